@@ -0,0 +1,236 @@
+/**
+ *   \file affinity.c
+ *   \brief Thread pinning, page placement and per-socket modeled traffic
+ *
+ *   The cores the process may run on are read once from its affinity mask
+ *   and the sysfs topology. A compact layout hands them out socket by
+ *   socket, a scatter layout alternates between the sockets so that every
+ *   socket gets a share of the memory bandwidth from the first threads on.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sched.h>
+#include <pthread.h>
+#include "affinity.h"
+
+#ifdef USE_LIBNUMA
+#include <numa.h>
+#endif
+
+static int  cores = 0;
+static int *compact = NULL;     /* cores ordered socket by socket */
+static int *scatter = NULL;     /* cores alternating over the sockets */
+static int *package = NULL;     /* socket of every core id */
+static int *sibling = NULL;     /* 0 for the first thread of a core, 1 for its twin */
+static int  packages = 1;
+static int  max_cpu = 0;
+static pthread_once_t topology_once = PTHREAD_ONCE_INIT;
+
+static int read_topology(int const cpu, const char *field) {
+  char path[256];
+  int value = 0;
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, field);
+  FILE *f = fopen(path, "r");
+  if (f == NULL) return 0;
+  if (fscanf(f, "%d", &value) != 1) value = 0;
+  fclose(f);
+  return value;
+}
+
+/* socket first, physical cores before their hyperthread twins */
+static int compare_core(const void *a, const void *b) {
+  int x = *(const int *)a, y = *(const int *)b;
+  if (package[x] != package[y]) return package[x] - package[y];
+  if (sibling[x] != sibling[y]) return sibling[x] - sibling[y];
+  return x - y;
+}
+
+static void topology_load(void) {
+  cpu_set_t set;
+  int *core_id;
+
+  CPU_ZERO(&set);
+  sched_getaffinity(0, sizeof(set), &set);
+  max_cpu = CPU_SETSIZE;
+  package = calloc(max_cpu, sizeof(int));
+  sibling = calloc(max_cpu, sizeof(int));
+  core_id = calloc(max_cpu, sizeof(int));
+  compact = malloc(max_cpu * sizeof(int));
+  scatter = malloc(max_cpu * sizeof(int));
+
+  for (int c = 0; c < max_cpu; c++) {
+    if (!CPU_ISSET(c, &set)) continue;
+    package[c] = read_topology(c, "physical_package_id");
+    core_id[c] = read_topology(c, "core_id");
+    if (package[c] + 1 > packages) packages = package[c] + 1;
+    for (int a = 0; a < cores; a++)
+      if (package[compact[a]] == package[c] && core_id[compact[a]] == core_id[c]) sibling[c]++;
+    compact[cores++] = c;
+  }
+  qsort(compact, cores, sizeof(int), compare_core);
+
+  /* scatter takes the k-th core of every socket before the (k+1)-th */
+  int *first = calloc(packages + 1, sizeof(int));
+  for (int a = 0; a < cores; a++) first[package[compact[a]] + 1]++;
+  for (int s = 0; s < packages; s++) first[s+1] += first[s];
+  for (int k = 0, filled = 0; filled < cores; k++)
+    for (int s = 0; s < packages; s++)
+      if (first[s] + k < first[s+1]) scatter[filled++] = compact[first[s] + k];
+
+  free(first);
+  free(core_id);
+}
+
+int affinity_parse(const char *name) {
+  if (name == NULL || strcmp(name, "none") == 0) return AFFINITY_NONE;
+  if (strcmp(name, "compact") == 0)              return AFFINITY_COMPACT;
+  if (strcmp(name, "scatter") == 0)              return AFFINITY_SCATTER;
+  return -1;
+}
+
+const char *affinity_name(int layout) {
+  switch (layout) {
+    case AFFINITY_COMPACT: return "compact";
+    case AFFINITY_SCATTER: return "scatter";
+    default:               return "none";
+  }
+}
+
+int affinity_parse_placement(const char *name) {
+  if (name == NULL || strcmp(name, "touch") == 0) return AFFINITY_TOUCH;
+  if (strcmp(name, "interleave") == 0)            return AFFINITY_INTERLEAVE;
+  return -1;
+}
+
+const char *affinity_placement_name(int placement) {
+  return placement == AFFINITY_INTERLEAVE ? "interleave" : "first touch";
+}
+
+/**
+ *  \brief Pin the calling thread to the core of worker id in the given layout
+ *
+ *  Returns the core the thread runs on, also when it is left unpinned.
+ */
+int affinity_pin(
+  int const              layout,
+  int const              id
+) {
+  pthread_once(&topology_once, topology_load);
+
+  if (layout != AFFINITY_NONE && cores > 0) {
+    int cpu = (layout == AFFINITY_SCATTER ? scatter : compact)[id % cores];
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0) return cpu;
+  }
+  return sched_getcpu();
+}
+
+/* Core the calling thread runs on right now */
+int affinity_cpu(void) {
+  return sched_getcpu();
+}
+
+int affinity_socket(int const cpu) {
+  pthread_once(&topology_once, topology_load);
+  return (cpu >= 0 && cpu < max_cpu) ? package[cpu] : 0;
+}
+
+int affinity_sockets(void) {
+  pthread_once(&topology_once, topology_load);
+  return packages;
+}
+
+/**
+ *  \brief Spread the pages of a shared read-mostly array over all NUMA nodes
+ *
+ *  Returns 1 if the pages will be interleaved, 0 without libnuma (build
+ *  with make NUMA=1) or on a machine with a single NUMA node.
+ */
+int affinity_interleave(void *ptr, size_t const bytes) {
+#ifdef USE_LIBNUMA
+  if (numa_available() >= 0 && numa_num_configured_nodes() > 1 && bytes > 0) {
+    /* mbind wants a page aligned start, the policy only affects pages touched later */
+    uintptr_t page = numa_pagesize();
+    uintptr_t first = (uintptr_t)ptr & ~(page - 1);
+    numa_interleave_memory((void *)first, (uintptr_t)ptr + bytes - first, numa_all_nodes_ptr);
+    return 1;
+  }
+#endif
+  (void)ptr;
+  (void)bytes;
+  return 0;
+}
+
+/**
+ *  \brief Modeled bytes the dot product form reads and writes for a column range
+ *
+ *  Both columns of every intersection, the column pointers and the C
+ *  value, counted from the list lengths. Caches and prefetching are not
+ *  in it, and the other engines move about as much.
+ */
+uint64_t affinity_column_bytes(
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         start,
+  uint32_t const         end
+) {
+  uint64_t bytes = 0;
+
+  for (uint32_t i = start; i < end; i++) {
+    uint32_t degree = cscColumn[i+1] - cscColumn[i];
+    for (uint32_t p = cscColumn[i]; p < cscColumn[i+1]; p++) {
+      uint32_t j = cscRow[p];
+      bytes += (uint64_t)(degree + cscColumn[j+1] - cscColumn[j]) * sizeof(uint32_t)
+               + 3 * sizeof(uint32_t);
+    }
+  }
+  return bytes;
+}
+
+/**
+ *  \brief Print the modeled traffic of every socket over its slowest worker
+ *
+ *  The bytes come from affinity_column_bytes, not from the memory
+ *  controllers, so the rate is what the model implies for the measured
+ *  time and not a measured bandwidth. Sockets without modeled bytes are
+ *  left out. Returns the modeled GB/s of all sockets together.
+ */
+double affinity_report(
+  int      const * const cpu,
+  uint64_t const * const bytes,
+  double   const * const seconds,
+  int const              workers,
+  const char * const     prefix
+) {
+  int S = affinity_sockets();
+  uint64_t *socket_bytes = calloc(S, sizeof(uint64_t));
+  double   *socket_time  = calloc(S, sizeof(double));
+  int      *socket_count = calloc(S, sizeof(int));
+
+  for (int w = 0; w < workers; w++) {
+    int s = affinity_socket(cpu[w]);
+    socket_bytes[s] += bytes[w];
+    socket_count[s]++;
+    if (seconds[w] > socket_time[s]) socket_time[s] = seconds[w];
+  }
+  uint64_t total = 0;
+  double slowest = 0;
+  for (int s = 0; s < S; s++) {
+    if (socket_count[s] == 0 || socket_bytes[s] == 0) continue;
+    printf("%sSocket %d: %d threads, %.3f GB modeled traffic, %.3f GB/s modeled", prefix, s, socket_count[s],
+           socket_bytes[s] / 1e9, socket_time[s] > 0 ? socket_bytes[s] / socket_time[s] / 1e9 : 0.0);
+    total += socket_bytes[s];
+    if (socket_time[s] > slowest) slowest = socket_time[s];
+  }
+
+  free(socket_bytes);
+  free(socket_time);
+  free(socket_count);
+  return slowest > 0 ? total / slowest / 1e9 : 0.0;
+}
@@ -0,0 +1,53 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Thread layouts over the sockets */
+#define AFFINITY_NONE     0   /* leave the threads to the scheduler */
+#define AFFINITY_COMPACT  1   /* fill one socket before the next */
+#define AFFINITY_SCATTER  2   /* round robin over the sockets */
+
+/* Placement of the read-mostly arrays */
+#define AFFINITY_TOUCH      0   /* pages land where the worker first writes them */
+#define AFFINITY_INTERLEAVE 1   /* pages spread over all nodes, needs libnuma */
+
+int affinity_parse(const char *name);
+
+const char *affinity_name(int layout);
+
+int affinity_parse_placement(const char *name);
+
+const char *affinity_placement_name(int placement);
+
+int affinity_pin(
+  int const              layout,    /*!< AFFINITY_COMPACT or AFFINITY_SCATTER */
+  int const              id         /*!< Worker id */
+);
+
+int affinity_cpu(void);
+
+int affinity_socket(int const cpu);
+
+int affinity_sockets(void);
+
+int affinity_interleave(void *ptr, size_t const bytes);
+
+uint64_t affinity_column_bytes(
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         start,     /*!< First column */
+  uint32_t const         end        /*!< One past the last column */
+);
+
+double affinity_report(
+  int      const * const cpu,       /*!< Core of every worker, -1 if unpinned */
+  uint64_t const * const bytes,     /*!< Modeled bytes of every worker, see affinity_column_bytes */
+  double   const * const seconds,   /*!< Time every worker spent in the kernel */
+  int const              workers,
+  const char * const     prefix     /*!< Printed before every socket line */
+);
+
+#endif
@@ -0,0 +1,438 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "spgemm.h"
+#include "generate.h"
+#include "affinity.h"
+#include "reorder.h"
+#include "libtriangle.h"
+
+/*
+ *  Benchmark driver: every engine under every reordering, pruned or not,
+ *  on every backend over a list of matrices and a thread sweep. Writes the Report/Excel/Triangles_Data
+ *  layout, one row per configuration and one column per matrix holding
+ *  the median duration, followed by the spread and the phase timings.
+ */
+
+#define BENCH_MAX 64
+
+typedef struct {
+  char      name[64];   /* configuration, V3_openmp_5 */
+  int       engine;
+  int       backend;
+  int       workers;    /* 0 for seq */
+  int       reorder;    /* REORDER_*, named after the backend unless none */
+  int       prune;      /* counted on the 2-core, named _pruned */
+  int       group;      /* a blank line separates groups in the CSV */
+} bench_config;
+
+typedef struct {
+  double    median, min, stddev;
+  double    build, prepare;
+  double    reorder;    /* part of build spent on the reordering */
+  double    kept;       /* share of the edges left by pruning */
+  double    modeled;    /* GB/s the traffic model implies, not measured */
+  uint64_t  triangles;
+  int       ran;
+} bench_cell;
+
+typedef struct {
+  char      row[64];
+  char      matrix[64];
+  double    median;
+} bench_baseline;
+
+static int compare_double(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/* Comma separated list into at most BENCH_MAX tokens, in place */
+static int split(char *list, char **out) {
+  int count = 0;
+  for (char *tok = strtok(list, ","); tok && count < BENCH_MAX; tok = strtok(NULL, ",")) out[count++] = tok;
+  return count;
+}
+
+static void config_name(char *name, size_t size, int engine, int backend, int workers, int reorder, int prune) {
+  char label[32];
+  size_t used;
+  if (engine == TRIANGLE_V3)        snprintf(label, sizeof(label), "V3");
+  else if (engine == SPGEMM_AUTO)   snprintf(label, sizeof(label), "V4");
+  else if (engine == TRIANGLE_AUTO) snprintf(label, sizeof(label), "Auto");
+  else                              snprintf(label, sizeof(label), "V4_%s", triangle_engine_name(engine));
+  if (backend == TRIANGLE_SEQ) snprintf(name, size, "%s", label);
+  else snprintf(name, size, "%s_%s_%d", label, triangle_backend_name(backend), workers);
+  used = strlen(name);
+  if (reorder != REORDER_NONE) snprintf(name + used, size - used, "_%s", reorder_name(reorder));
+  used = strlen(name);
+  if (prune) snprintf(name + used, size - used, "_pruned");
+}
+
+/* The matrix label is given as Name=path or taken from the file name */
+static void matrix_name(char *name, size_t size, char *arg, char **path) {
+  char *eq = strchr(arg, '='), *colon = strchr(arg, ':');
+  if (eq && (colon == NULL || eq < colon)) {
+    *eq = '\0';
+    snprintf(name, size, "%s", arg);
+    *path = eq + 1;
+    return;
+  }
+  *path = arg;
+  if (colon && generate_is_spec(arg)) {
+    /* A generator spec names itself, without the commas that split CSV cells */
+    snprintf(name, size, "%s", arg);
+    for (char *s = name; *s; s++) if (*s == ',') *s = ' ';
+    return;
+  }
+  char *base = strrchr(arg, '/');
+  snprintf(name, size, "%s", base ? base + 1 : arg);
+  char *dot = strrchr(name, '.');
+  if (dot) *dot = '\0';
+}
+
+/* The per matrix columns after the medians, Belgium_min and so on, in the order both writers emit them */
+#define BENCH_COLUMNS 7
+static const char *column_suffix[BENCH_COLUMNS] = { "_min", "_stddev", "_build", "_prepare", "_triangles", "_modeled_gbs", "_reorder" };
+
+static void write_column(FILE *f, bench_cell const *x, int column) {
+  switch (column) {
+    case 0:  fprintf(f, "%g", x->min);                                 break;
+    case 1:  fprintf(f, "%g", x->stddev);                              break;
+    case 2:  fprintf(f, "%g", x->build);                               break;
+    case 3:  fprintf(f, "%g", x->prepare);                             break;
+    case 4:  fprintf(f, "%llu", (unsigned long long)x->triangles);     break;
+    case 5:  fprintf(f, "%g", x->modeled);                             break;
+    default: fprintf(f, "%g", x->reorder);                             break;
+  }
+}
+
+/*
+ *  Reads back the JSON written by write_json, flat objects of numbers.
+ *  Every row lists the medians first, under the bare matrix names, so the
+ *  first value of a key in a row is the one kept: a matrix named road_min
+ *  is not confused with the _min column of a matrix named road.
+ */
+static int load_baseline(const char *filename, bench_baseline **out) {
+  FILE *f = fopen(filename, "r");
+  if (f == NULL) return -1;
+  int count = 0, capacity = 64;
+  bench_baseline *b = malloc(capacity * sizeof(bench_baseline));
+  char row[64] = "", key[64];
+  int c;
+
+  while ((c = fgetc(f)) != EOF) {
+    if (c != '"') continue;
+    if (fscanf(f, "%63[^\"]\"", key) != 1) break;
+    while ((c = fgetc(f)) != EOF && (c == ' ' || c == ':'));
+    if (c == '"') {
+      if (fscanf(f, "%63[^\"]\"", row) != 1) break;
+      continue;
+    }
+    ungetc(c, f);
+    double value;
+    if (fscanf(f, "%lf", &value) != 1) continue;
+    int seen = 0;
+    for (int k = count - 1; k >= 0 && strcmp(b[k].row, row) == 0 && !seen; k--) seen = strcmp(b[k].matrix, key) == 0;
+    if (seen) continue;
+    if (count == capacity) b = realloc(b, (capacity *= 2) * sizeof(bench_baseline));
+    snprintf(b[count].row, sizeof(b[count].row), "%s", row);
+    snprintf(b[count].matrix, sizeof(b[count].matrix), "%s", key);
+    b[count++].median = value;
+  }
+  fclose(f);
+  *out = b;
+  return count;
+}
+
+static void write_csv(const char *filename, bench_config const *cfg, int configs,
+                      char names[][64], int matrices, bench_cell *cell) {
+  FILE *f = fopen(filename, "w");
+  if (f == NULL) { fprintf(stderr, "Cannot write %s\n", filename); return; }
+
+  /* The same columns as write_json, the separator row is as wide as the header */
+  int fields = 1;
+  for (int m = 0; m < matrices; m++, fields++) fprintf(f, ",%s", names[m]);
+  for (int m = 0; m < matrices; m++)
+    for (int k = 0; k < BENCH_COLUMNS; k++, fields++) fprintf(f, ",%s%s", names[m], column_suffix[k]);
+  fprintf(f, "\n");
+  for (int c = 0; c < configs; c++) {
+    if (c > 0 && cfg[c].group != cfg[c-1].group) {
+      for (int k = 1; k < fields; k++) fprintf(f, ",");
+      fprintf(f, "\n");
+    }
+    fprintf(f, "%s", cfg[c].name);
+    for (int m = 0; m < matrices; m++) fprintf(f, ",%g", cell[c * matrices + m].median);
+    for (int m = 0; m < matrices; m++)
+      for (int k = 0; k < BENCH_COLUMNS; k++) {
+        fprintf(f, ",");
+        write_column(f, &cell[c * matrices + m], k);
+      }
+    fprintf(f, "\n");
+  }
+  fclose(f);
+}
+
+static void write_json(const char *filename, bench_config const *cfg, int configs,
+                       char names[][64], int matrices, bench_cell *cell) {
+  FILE *f = fopen(filename, "w");
+  if (f == NULL) { fprintf(stderr, "Cannot write %s\n", filename); return; }
+
+  fprintf(f, "[");
+  for (int c = 0; c < configs; c++) {
+    fprintf(f, "%s\n  {\n    \"Duration\": \"%s\"", c ? "," : "", cfg[c].name);
+    for (int m = 0; m < matrices; m++) fprintf(f, ",\n    \"%s\": %g", names[m], cell[c * matrices + m].median);
+    for (int m = 0; m < matrices; m++)
+      for (int k = 0; k < BENCH_COLUMNS; k++) {
+        fprintf(f, ",\n    \"%s%s\": ", names[m], column_suffix[k]);
+        write_column(f, &cell[c * matrices + m], k);
+      }
+    fprintf(f, "\n  }");
+  }
+  fprintf(f, "\n]\n");
+  fclose(f);
+}
+
+int main(int argc, char *argv[])
+{
+  char engines_arg[256] = "v3,v4", backends_arg[256] = "seq,openmp,cilk,pthreads", threads_arg[256] = "1,5,10,15,20";
+  char reorders_arg[256] = "none";
+  const char *csv = "Triangles_Data.csv", *json = "Triangles_Data.json", *baseline = NULL;
+  int warmup = 1, repeat = 5, prunes = 1;
+  double threshold = 0.10;
+  char *files[BENCH_MAX];
+  int matrices = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--engines") == 0 && i + 1 < argc)        snprintf(engines_arg, sizeof(engines_arg), "%s", argv[++i]);
+    else if (strcmp(argv[i], "--backends") == 0 && i + 1 < argc)  snprintf(backends_arg, sizeof(backends_arg), "%s", argv[++i]);
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)   snprintf(threads_arg, sizeof(threads_arg), "%s", argv[++i]);
+    else if (strcmp(argv[i], "--reorders") == 0 && i + 1 < argc)  snprintf(reorders_arg, sizeof(reorders_arg), "%s", argv[++i]);
+    else if (strcmp(argv[i], "--prune") == 0)                     prunes = 2;
+    else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)    warmup = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)    repeat = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)       csv = argv[++i];
+    else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)      json = argv[++i];
+    else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)  baseline = argv[++i];
+    else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) threshold = atof(argv[++i]);
+    else if (argv[i][0] != '-' && matrices < BENCH_MAX)           files[matrices++] = argv[i];
+    else matrices = 0, i = argc;
+  }
+  if (matrices == 0 || repeat < 1) {
+    fprintf(stderr, "Usage: %s [Name=]file.mtx|file.csc|rmat:...|er:...|mycielskian:k=K ... [--engines v3,v4,dot,...] [--backends seq,openmp,cilk,pthreads] [--threads 1,5,10,15,20] [--reorders none,degree,rcm,gorder] [--prune] [--warmup 1] [--repeat 5] [--csv out.csv] [--json out.json] [--baseline old.json] [--threshold 0.10]\n", argv[0]);
+    exit(1);
+  }
+
+  /* Every engine, reordering and pruning on seq once, and on every parallel backend per thread count, Cilk on the first */
+  char *engine_list[BENCH_MAX], *backend_list[BENCH_MAX], *thread_list[BENCH_MAX], *reorder_list[BENCH_MAX];
+  int engines = split(engines_arg, engine_list);
+  int backends = split(backends_arg, backend_list);
+  int sweeps = split(threads_arg, thread_list);
+  int reorders = split(reorders_arg, reorder_list);
+  bench_config *cfg = malloc(engines * reorders * prunes * (1 + backends * sweeps) * sizeof(bench_config));
+  int configs = 0, group = 0;
+
+  for (int e = 0; e < engines * reorders * prunes; e++) {
+    int engine = triangle_parse_engine(engine_list[e / (reorders * prunes)]);
+    int reorder = reorder_parse(reorder_list[e / prunes % reorders]);
+    int prune = e % prunes;
+    if (engine < 0) { fprintf(stderr, "Unknown engine %s\n", engine_list[e / (reorders * prunes)]); exit(1); }
+    if (reorder < 0) { fprintf(stderr, "Unknown reordering %s\n", reorder_list[e / prunes % reorders]); exit(1); }
+    for (int b = 0; b < backends; b++) {
+      int backend = triangle_parse_backend(backend_list[b]);
+      if (backend < 0) { fprintf(stderr, "Unknown backend %s\n", backend_list[b]); exit(1); }
+      int workers = backend == TRIANGLE_SEQ ? 1 : sweeps;
+      for (int t = 0; t < workers; t++) {
+        bench_config *c = &cfg[configs];
+        triangle_options opt;
+        triangle_default_options(&opt);
+        opt.backend = backend;
+        opt.workers = backend == TRIANGLE_SEQ ? 0 : atoi(thread_list[t]);
+        /* Backends missing from this build, Cilk without CILK=1, are left out */
+        int running = triangle_workers(&opt);
+        if (running < 1) break;
+        c->engine = engine;
+        c->backend = backend;
+        c->workers = backend == TRIANGLE_SEQ ? 0 : running;   /* named by what runs, not what was asked */
+        c->reorder = reorder;
+        c->prune = prune;
+        c->group = group;
+        config_name(c->name, sizeof(c->name), engine, backend, c->workers, reorder, prune);
+        configs++;
+        /* The Cilk runtime cannot be resized once started, it gets the first count only */
+        if (backend == TRIANGLE_CILK) break;
+      }
+      group++;
+    }
+  }
+
+  char (*names)[64] = malloc(matrices * sizeof(*names));
+  bench_cell *cell = calloc(configs * matrices, sizeof(bench_cell));
+  double *sample = malloc(repeat * sizeof(double));
+  int mismatch = 0;
+
+  for (int m = 0; m < matrices; m++) {
+    char *path;
+    triangle_coo coo;
+    matrix_name(names[m], sizeof(names[m]), files[m], &path);
+    triangle_options defaults;
+    triangle_default_options(&defaults);
+    double load = profile_now();
+    if (triangle_load(path, &defaults, &coo) != 0) { fprintf(stderr, "Cannot read %s\n", path); exit(1); }
+    printf("%s: n = %u, nz = %u, load %f\n", names[m], coo.n, coo.nz, profile_now() - load);
+
+    uint64_t reference = 0;
+    int have_reference = 0;
+    for (int c = 0; c < configs; c++) {
+      triangle_options opt;
+      triangle_graph g;
+      triangle_result r;
+      bench_cell *x = &cell[c * matrices + m];
+
+      triangle_default_options(&opt);
+      opt.engine = cfg[c].engine;
+      opt.backend = cfg[c].backend;
+      opt.workers = cfg[c].workers;
+      opt.reorder = cfg[c].reorder;
+      opt.prune = cfg[c].prune;
+
+      /* triangle_build relabels in place, so it gets a copy */
+      triangle_coo copy = coo;
+      copy.row = malloc(((size_t)coo.nz + 1) * sizeof(uint32_t));
+      copy.col = malloc(((size_t)coo.nz + 1) * sizeof(uint32_t));
+      memcpy(copy.row, coo.row, coo.nz * sizeof(uint32_t));
+      memcpy(copy.col, coo.col, coo.nz * sizeof(uint32_t));
+      double build = profile_now();
+      triangle_build(&copy, &opt, &g);
+      x->build = profile_now() - build;
+      x->reorder = g.reorder_time;
+      if (cfg[c].prune) x->kept = g.prune.edges ? (double)g.prune.kept_edges / g.prune.edges : 1;
+      triangle_coo_free(&copy);
+      if (g.packed && cfg[c].backend == TRIANGLE_SEQ)
+        printf("  %-24s rows packed to %.2f MB from %.2f MB (%.2fx)\n", cfg[c].name, g.packed->bytes / 1e6,
+               g.nnz * sizeof(uint32_t) / 1e6, (double)g.nnz * sizeof(uint32_t) / g.packed->bytes);
+
+      for (int rep = -warmup; rep < repeat; rep++) {
+        if (triangle_count(&g, &opt, &r) != 0) break;
+        if (rep >= 0) {
+          sample[rep] = r.duration;
+          x->prepare += r.prepare_time / repeat;
+          x->ran++;
+        }
+        /* Every run of every configuration has to find the same triangles */
+        if (!have_reference) {
+          reference = r.triangles;
+          have_reference = 1;
+        }
+        if (r.triangles != reference) {
+          printf("MISMATCH %s on %s: %llu triangles, expected %llu\n", cfg[c].name, names[m],
+                 (unsigned long long)r.triangles, (unsigned long long)reference);
+          mismatch = 1;
+        }
+        x->triangles = r.triangles;
+        triangle_result_free(&r);
+      }
+
+      /* One more run outside the samples, profiled, for the modeled traffic per socket */
+      profile prof;
+      memset(&prof, 0, sizeof(profile));
+      opt.profile = &prof;
+      int profiled = x->ran > 0 && triangle_count(&g, &opt, &r) == 0;
+      if (profiled) triangle_result_free(&r);
+      triangle_graph_free(&g);
+
+      if (x->ran > 0) {
+        double mean = 0, var = 0;
+        qsort(sample, x->ran, sizeof(double), compare_double);
+        x->median = x->ran % 2 ? sample[x->ran / 2] : (sample[x->ran / 2 - 1] + sample[x->ran / 2]) / 2;
+        x->min = sample[0];
+        for (int s = 0; s < x->ran; s++) mean += sample[s] / x->ran;
+        for (int s = 0; s < x->ran; s++) var += (sample[s] - mean) * (sample[s] - mean) / x->ran;
+        x->stddev = sqrt(var);
+      }
+      printf("  %-24s median %f  min %f  stddev %f  triangles %llu", cfg[c].name,
+             x->median, x->min, x->stddev, (unsigned long long)x->triangles);
+      if (profiled)
+        x->modeled = affinity_report(prof.worker_cpu, prof.worker_bytes, prof.worker_seconds, prof.workers,
+                                     "\n    ");
+      printf("\n");
+      profile_free(&prof);
+    }
+
+    /* What hub bitmaps or packed rows change against the plain merge, same backend and threads */
+    for (int c = 0; c < configs; c++) {
+      if (cfg[c].engine != TRIANGLE_HUBS && cfg[c].engine != TRIANGLE_PACKED) continue;
+      for (int d = 0; d < configs; d++) {
+        bench_cell *x = &cell[c * matrices + m], *y = &cell[d * matrices + m];
+        if (cfg[d].engine != SPGEMM_DOT || cfg[d].backend != cfg[c].backend || cfg[d].workers != cfg[c].workers ||
+            cfg[d].reorder != cfg[c].reorder || cfg[d].prune != cfg[c].prune ||
+            x->ran == 0 || y->ran == 0 || x->median <= 0) continue;
+        printf("  %-24s %.2fx over %s\n", cfg[c].name, y->median / x->median, cfg[d].name);
+      }
+    }
+
+    /* What a reordering costs and what it buys the kernel, against none on the same engine and workers */
+    for (int c = 0; c < configs; c++) {
+      if (cfg[c].reorder == REORDER_NONE) continue;
+      for (int d = 0; d < configs; d++) {
+        bench_cell *x = &cell[c * matrices + m], *y = &cell[d * matrices + m];
+        if (cfg[d].reorder != REORDER_NONE || cfg[d].engine != cfg[c].engine || cfg[d].backend != cfg[c].backend ||
+            cfg[d].workers != cfg[c].workers || cfg[d].prune != cfg[c].prune ||
+            x->ran == 0 || y->ran == 0 || x->median <= 0) continue;
+        printf("  %-24s reorder %f, kernel %.2fx over %s\n", cfg[c].name, x->reorder, y->median / x->median,
+               cfg[d].name);
+      }
+    }
+
+    /* Pruning pays in the build, so build and kernel together against the unpruned run */
+    for (int c = 0; c < configs; c++) {
+      if (!cfg[c].prune) continue;
+      for (int d = 0; d < configs; d++) {
+        bench_cell *x = &cell[c * matrices + m], *y = &cell[d * matrices + m];
+        if (cfg[d].prune || cfg[d].engine != cfg[c].engine || cfg[d].backend != cfg[c].backend ||
+            cfg[d].workers != cfg[c].workers || cfg[d].reorder != cfg[c].reorder || x->ran == 0 || y->ran == 0) continue;
+        printf("  %-24s build+kernel %f against %f, %.2fx over %s, %.1f%% of the edges kept\n", cfg[c].name,
+               x->build + x->median, y->build + y->median, (y->build + y->median) / (x->build + x->median),
+               cfg[d].name, 100 * x->kept);
+      }
+    }
+    triangle_coo_free(&coo);
+  }
+
+  write_csv(csv, cfg, configs, names, matrices, cell);
+  write_json(json, cfg, configs, names, matrices, cell);
+  printf("Wrote %s and %s\n", csv, json);
+
+  /* Slower than the baseline by more than threshold counts as a regression */
+  int regressions = 0;
+  if (baseline) {
+    bench_baseline *base;
+    int count = load_baseline(baseline, &base);
+    if (count < 0) fprintf(stderr, "Cannot read baseline %s\n", baseline);
+    for (int k = 0; k < count; k++) {
+      for (int c = 0; c < configs; c++) {
+        if (strcmp(cfg[c].name, base[k].row) != 0) continue;
+        for (int m = 0; m < matrices; m++) {
+          bench_cell *x = &cell[c * matrices + m];
+          if (strcmp(names[m], base[k].matrix) != 0 || x->ran == 0 || base[k].median <= 0) continue;
+          if (x->median > base[k].median * (1 + threshold)) {
+            printf("REGRESSION %s on %s: %f -> %f (+%.1f%%)\n", cfg[c].name, names[m], base[k].median,
+                   x->median, 100 * (x->median / base[k].median - 1));
+            regressions++;
+          }
+        }
+      }
+    }
+    if (count >= 0) {
+      printf("Baseline %s: %d regressions over %.0f%%\n", baseline, regressions, 100 * threshold);
+      free(base);
+    }
+  }
+
+  free(cfg);
+  free(names);
+  free(cell);
+  free(sample);
+  return mismatch ? 2 : (regressions ? 3 : 0);
+}
@@ -0,0 +1,49 @@
+#ifndef BITMATRIX_H
+#define BITMATRIX_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Vertices of a candidate diagonal block, 32 words per row */
+#define BITMATRIX_BLOCK 2048
+/* A block is kept from this density on, a row word then holds one entry */
+#define BITMATRIX_MIN_DENSITY (1.0 / 64)
+/* Upper bound for the bits of all blocks together (bytes) */
+#define BITMATRIX_BUDGET (256u << 20)
+
+#define BITMATRIX_NONE UINT32_MAX
+
+typedef struct {
+  uint32_t   blocks;     /*!< Dense diagonal blocks, one covering everything for a dense graph */
+  uint32_t  *first;      /*!< First vertex of every block */
+  uint32_t  *size;       /*!< Vertices of every block */
+  uint32_t  *words;      /*!< 64 bit words per row of every block */
+  uint64_t **bits;       /*!< Rows of every block, row v at (v - first) * words */
+  uint32_t  *block;      /*!< Block of every vertex, BITMATRIX_NONE outside all */
+  uint32_t  *inside;     /*!< Per vertex the range of its list inside its block (2n) */
+  size_t     bytes;      /*!< Memory of the bits */
+  double     density;    /*!< Density over the kept blocks */
+} bitmatrix;
+
+double bitmatrix_bytes(uint32_t const n);
+
+bitmatrix *bitmatrix_build(
+  uint32_t const * const cscRow,     /*!< CSC row indices of the full matrix, sorted per column */
+  uint32_t const * const cscColumn,  /*!< CSC column start indices */
+  uint32_t const         n,          /*!< Number of rows/columns */
+  size_t const           budget      /*!< Bytes the bits may take */
+);
+
+void bitmatrix_free(bitmatrix *bm);
+
+void bitmatrix_dot(
+  bitmatrix      const * const bm,
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         start,      /*!< First column to compute */
+  uint32_t const         end,        /*!< One past the last column */
+  uint32_t       * const c_values    /*!< C value of every nonzero */
+);
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ *   \file canon.c
+ *   \brief Canonical COO: every edge once, row > col, sorted by column then row
+ *
+ *   Every loader runs its coordinates through canon_coo before building
+ *   anything. Entries above the diagonal are flipped below it, self-loops
+ *   and entries outside the n x n matrix are dropped, and an edge stored
+ *   more than once, in one orientation or both as in a general matrix, is
+ *   kept once. The result is sorted by
+ *   column then row, so coo2csc, coo2csc_symmetric and lowertri_build give
+ *   sorted columns from it without another sort.
+ *
+ *   One parallel pass orients the entries and one checks their order.
+ *   Input that is already canonical, like every file of gen, stops there.
+ *   Anything else is bucketed by column, sorted within the columns and
+ *   stripped of repeats, one column per iteration of a parallel loop.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "canon.h"
+#include "reorder.h"
+
+uint32_t canon_coo(
+  uint32_t       * const row_coo,
+  uint32_t       * const col_coo,
+  uint32_t const         nz,
+  uint32_t const         n,
+  canon_stats    * const s
+) {
+  uint32_t flipped = 0, loops = 0, outside = 0, unordered = 0;
+
+  memset(s, 0, sizeof(canon_stats));
+  s->entries = nz;
+
+  // ----- orient, the row is the larger index
+  #pragma omp parallel for schedule(static) reduction(+:flipped, loops, outside)
+  for (uint32_t l = 0; l < nz; l++) {
+    uint32_t a = row_coo[l], b = col_coo[l];
+    if (a >= n || b >= n) outside++;   /* a 0 in a 1-based file wraps to UINT32_MAX too */
+    else if (a < b) {
+      row_coo[l] = b;
+      col_coo[l] = a;
+      flipped++;
+    }
+    else if (a == b) loops++;
+  }
+
+  // ----- strictly increasing (col, row) leaves nothing to sort or drop
+  #pragma omp parallel for schedule(static) reduction(+:unordered)
+  for (uint32_t l = 1; l < nz; l++)
+    unordered += col_coo[l] < col_coo[l-1] || (col_coo[l] == col_coo[l-1] && row_coo[l] <= row_coo[l-1]);
+
+  s->flipped = flipped;
+  s->self_loops = loops;
+  s->out_of_range = outside;
+  if (loops == 0 && outside == 0 && unordered == 0) {
+    s->edges = nz;
+    s->was_canonical = flipped == 0;
+    return nz;
+  }
+
+  uint32_t *pointer = calloc((size_t)n + 1, sizeof(uint32_t));
+  uint32_t *kept = malloc(((size_t)n + 1) * sizeof(uint32_t));
+  uint32_t *rows = malloc(((size_t)nz + 1) * sizeof(uint32_t));
+
+  // ----- bucket by column without the diagonal and what lies outside
+  for (uint32_t l = 0; l < nz; l++)
+    if (row_coo[l] > col_coo[l] && row_coo[l] < n) pointer[col_coo[l] + 1]++;
+  for (uint32_t i = 0; i < n; i++)
+    pointer[i+1] += pointer[i];
+  for (uint32_t l = 0; l < nz; l++)
+    if (row_coo[l] > col_coo[l] && row_coo[l] < n) rows[pointer[col_coo[l]]++] = row_coo[l];
+  for (uint32_t i = n; i > 0; i--)
+    pointer[i] = pointer[i-1];
+  pointer[0] = 0;
+
+  reorder_sort_columns(rows, pointer, n);
+
+  // ----- drop repeats, kept[j+1] is what is left of column j
+  kept[0] = 0;
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (uint32_t j = 0; j < n; j++) {
+    uint32_t first = pointer[j], k = first;
+    for (uint32_t p = first; p < pointer[j+1]; p++)
+      if (k == first || rows[p] != rows[k-1]) rows[k++] = rows[p];
+    kept[j+1] = k - first;
+  }
+  for (uint32_t i = 0; i < n; i++)
+    kept[i+1] += kept[i];
+
+  // ----- back into the COO, column by column
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (uint32_t j = 0; j < n; j++) {
+    uint32_t from = pointer[j];
+    for (uint32_t p = kept[j]; p < kept[j+1]; p++) {
+      row_coo[p] = rows[from++];
+      col_coo[p] = j;
+    }
+  }
+
+  s->edges = kept[n];
+  s->duplicates = nz - loops - outside - kept[n];
+  free(pointer);
+  free(kept);
+  free(rows);
+  return s->edges;
+}
+
+void canon_print(canon_stats const *s) {
+  printf("\nInput: %s%u entries, %u edges", s->general ? "general matrix, " : "", s->entries, s->edges);
+  if (s->was_canonical) printf(", already canonical\n");
+  else printf(", %u flipped below the diagonal, %u self-loops, %u duplicates and %u out of range dropped\n",
+              s->flipped, s->self_loops, s->duplicates, s->out_of_range);
+}
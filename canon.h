@@ -0,0 +1,29 @@
+#ifndef CANON_H
+#define CANON_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+typedef struct {
+  uint32_t  entries;      /*!< COO entries before */
+  uint32_t  edges;        /*!< Distinct edges kept */
+  uint32_t  flipped;      /*!< Entries stored above the diagonal */
+  uint32_t  self_loops;   /*!< Diagonal entries dropped */
+  uint32_t  duplicates;   /*!< Repeated edges dropped, in either orientation */
+  uint32_t  out_of_range; /*!< Entries with an index of n or more dropped */
+  int       was_canonical;/*!< Input already canonical, nothing moved, or vouched for by the loader and not checked */
+  int       general;      /*!< Banner is general, not symmetric, set by the caller */
+} canon_stats;
+
+uint32_t canon_coo(
+  uint32_t       * const row_coo,   /*!< COO row indices, 0-based, rewritten */
+  uint32_t       * const col_coo,   /*!< COO column indices, 0-based, rewritten */
+  uint32_t const         nz,        /*!< Number of COO entries */
+  uint32_t const         n,         /*!< Number of rows/columns */
+  canon_stats    * const s          /*!< What was fixed, out */
+);
+
+void canon_print(canon_stats const *s);
+
+#endif
@@ -64,6 +64,53 @@ void coo2csc(
 
 }
 
+/**
+ *  \brief COO of one triangle to the CSC of the full symmetric matrix
+ *
+ *  Same result as coo2csc on the COO followed by its mirror, without the
+ *  mirrored copy: the degrees of both orientations are counted in one
+ *  pass over the entries and every entry is scattered twice, first as
+ *  given and then mirrored. The scatter order is the one of the mirrored
+ *  COO, so columns come out sorted whenever they did before.
+ */
+void coo2csc_symmetric(
+  uint32_t       * const row,
+  uint32_t       * const col,
+  uint32_t const * const row_coo,
+  uint32_t const * const col_coo,
+  uint32_t const         nnz,
+  uint32_t const         n
+) {
+
+  for (uint32_t l = 0; l < n+1; l++) col[l] = 0;
+
+  // ----- column sizes, each entry lands in its column and in its row's
+  for (uint32_t l = 0; l < nnz; l++) {
+    col[col_coo[l]]++;
+    col[row_coo[l]]++;
+  }
+
+  // ----- cumulative sum
+  for (uint32_t i = 0, cumsum = 0; i < n; i++) {
+    uint32_t temp = col[i];
+    col[i] = cumsum;
+    cumsum += temp;
+  }
+  col[n] = 2 * nnz;
+
+  // ----- the entries as given, then mirrored
+  for (uint32_t l = 0; l < nnz; l++) row[col[col_coo[l]]++] = row_coo[l];
+  for (uint32_t l = 0; l < nnz; l++) row[col[row_coo[l]]++] = col_coo[l];
+
+  // ----- revert the column pointers
+  for (uint32_t i = 0, last = 0; i < n; i++) {
+    uint32_t temp = col[i];
+    col[i] = last;
+    last = temp;
+  }
+
+}
+
 /*****************************************************************************/
 /*                 setup example and assert correct behavior                 */
 /*****************************************************************************/
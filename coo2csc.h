@@ -15,4 +15,13 @@ void coo2csc(
   uint32_t const         isOneBased /*!< Whether COO is 0- or 1-based */
 );
 
+void coo2csc_symmetric(
+  uint32_t       * const row,       /*!< CSC row indices (size 2*nnz) */
+  uint32_t       * const col,       /*!< CSC column start indices (size n+1) */
+  uint32_t const * const row_coo,   /*!< COO row indices of one triangle, 0-based */
+  uint32_t const * const col_coo,   /*!< COO column indices of one triangle, 0-based */
+  uint32_t const         nnz,       /*!< Number of COO entries */
+  uint32_t const         n          /*!< Number of rows/columns */
+);
+
 #endif
\ No newline at end of file
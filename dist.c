@@ -0,0 +1,243 @@
+/**
+ *   \file dist.c
+ *   \brief Loading, partitioning and reporting shared by the MPI engines
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <mpi.h>
+#include "mmio.h"
+#include "canon.h"
+#include "dist.h"
+
+static const char *phase_name[DIST_PHASES] = { "load", "exchange", "count", "reduce" };
+
+uint32_t dist_owner(dist_graph const * const g, uint32_t const v) {
+  int lo = 0, hi = g->size - 1;
+  while (lo < hi) {
+    int mid = lo + (hi - lo + 1) / 2;
+    if (g->bound[mid] <= v) lo = mid;
+    else                    hi = mid - 1;
+  }
+  return lo;
+}
+
+/**
+ *  \brief Read the coordinates of a Matrix Market file, 0-based
+ *
+ *  Returns 1 when the file is short or an entry does not parse. Indices
+ *  outside 1..N are left for canon_coo to drop.
+ */
+int dist_read_mtx(
+  const char * const     filename,
+  uint32_t            ** I,
+  uint32_t            ** J,
+  int            * const nz,
+  int            * const N
+) {
+  MM_typecode matcode;
+  int M;
+  double val;
+  FILE *f = fopen(filename, "r");
+
+  if (f == NULL) return 1;
+  if (mm_read_banner(f, &matcode) != 0 || mm_read_mtx_crd_size(f, &M, N, nz) != 0) {
+    fclose(f);
+    return 1;
+  }
+  *I = malloc((*nz + 1) * sizeof(uint32_t));
+  *J = malloc((*nz + 1) * sizeof(uint32_t));
+  int pattern = mm_is_pattern(matcode), bad = 0;
+  for (int i = 0; i < *nz && !bad; i++) {
+    if (pattern) bad = fscanf(f, "%u %u\n", &(*I)[i], &(*J)[i]) != 2;
+    else         bad = fscanf(f, "%u %u %lg\n", &(*I)[i], &(*J)[i], &val) != 3;
+    (*I)[i]--;  /* adjust from 1-based to 0-based */
+    (*J)[i]--;
+  }
+  fclose(f);
+  if (bad) {
+    free(*I);
+    free(*J);
+  }
+  return bad;
+}
+
+/**
+ *  \brief Rank 0 reads the file, every rank receives the columns of L it owns
+ *
+ *  Rank 0 runs the edges through canon_coo first, so repeated entries,
+ *  both triangles of a general file and self-loops never leave it.
+ *  Column blocks are chosen so that every rank gets about the same number
+ *  of nonzeros of L, not the same number of vertices. Returns 0 on
+ *  success on every rank.
+ */
+int dist_load_mtx(
+  const char * const     filename,
+  MPI_Comm const         comm,
+  dist_graph           * g,
+  dist_stats           * st
+) {
+  double start = MPI_Wtime();
+  int ok = 1;
+  uint32_t *pairs = NULL;
+  int *sendcounts = NULL, *displs = NULL;
+  uint32_t header[2] = { 0, 0 };
+
+  memset(g, 0, sizeof(dist_graph));
+  MPI_Comm_rank(comm, &g->rank);
+  MPI_Comm_size(comm, &g->size);
+  g->bound = malloc((g->size + 1) * sizeof(uint32_t));
+
+  if (g->rank == 0) {
+    uint32_t *I, *J;
+    int N, nz;
+
+    if (dist_read_mtx(filename, &I, &J, &nz, &N) != 0) {
+      printf("Could not read %s\n", filename);
+      ok = 0;
+    }
+    else {
+      // ----- every edge once as (row = max, col = min), sorted by column
+      canon_stats cs;
+      nz = canon_coo(I, J, nz, N, &cs);
+
+      // ----- column sizes of L and the balanced column blocks
+      uint32_t *degree = calloc(N, sizeof(uint32_t));
+      uint64_t total = nz;
+      for (int i = 0; i < nz; i++) degree[J[i]]++;
+      g->bound[0] = 0;
+      uint64_t seen = 0;
+      int r = 1;
+      for (uint32_t v = 0; v < (uint32_t)N && r < g->size; v++) {
+        seen += degree[v];
+        while (r < g->size && seen >= total * r / g->size) g->bound[r++] = v + 1;
+      }
+      while (r <= g->size) g->bound[r++] = N;
+      free(degree);
+
+      // ----- pack (row, col) pairs by owner of the column, still in column order
+      g->n = N;
+      sendcounts = calloc(g->size, sizeof(int));
+      displs = calloc(g->size + 1, sizeof(int));
+      for (int i = 0; i < nz; i++) sendcounts[dist_owner(g, J[i])] += 2;
+      for (int q = 0; q < g->size; q++) displs[q+1] = displs[q] + sendcounts[q];
+      pairs = malloc((displs[g->size] + 1) * sizeof(uint32_t));
+      int *fill = malloc(g->size * sizeof(int));
+      memcpy(fill, displs, g->size * sizeof(int));
+      for (int i = 0; i < nz; i++) {
+        int q = dist_owner(g, J[i]);
+        pairs[fill[q]++] = I[i];
+        pairs[fill[q]++] = J[i];
+      }
+      free(fill);
+      free(I);
+      free(J);
+      header[1] = N;
+    }
+    header[0] = ok;
+  }
+
+  MPI_Bcast(header, 2, MPI_UINT32_T, 0, comm);
+  if (!header[0]) return 1;
+  g->n = header[1];
+  MPI_Bcast(g->bound, g->size + 1, MPI_UINT32_T, 0, comm);
+  g->first = g->bound[g->rank];
+  g->last  = g->bound[g->rank + 1];
+
+  int count;
+  MPI_Scatter(sendcounts, 1, MPI_INT, &count, 1, MPI_INT, 0, comm);
+  uint32_t *mine = malloc((count + 1) * sizeof(uint32_t));
+  MPI_Scatterv(pairs, sendcounts, displs, MPI_UINT32_T, mine, count, MPI_UINT32_T, 0, comm);
+  if (g->rank == 0) st->bytes[DIST_LOAD] += (uint64_t)displs[g->size] * sizeof(uint32_t);
+
+  // ----- local CSC of the own columns, sorted since the pairs arrive in column order
+  uint32_t columns = g->last - g->first;
+  g->nnz = count / 2;
+  g->col = calloc(columns + 1, sizeof(uint32_t));
+  g->row = malloc((g->nnz + 1) * sizeof(uint32_t));
+  for (uint32_t l = 0; l < g->nnz; l++) g->col[mine[2*l+1] - g->first + 1]++;
+  for (uint32_t c = 0; c < columns; c++) g->col[c+1] += g->col[c];
+  for (uint32_t l = 0; l < g->nnz; l++) g->row[g->col[mine[2*l+1] - g->first]++] = mine[2*l];
+  for (uint32_t c = columns; c > 0; c--) g->col[c] = g->col[c-1];
+  g->col[0] = 0;
+
+  free(mine);
+  free(pairs);
+  free(sendcounts);
+  free(displs);
+
+  st->time[DIST_LOAD] += MPI_Wtime() - start;
+  return 0;
+}
+
+void dist_free(dist_graph *g) {
+  free(g->bound);
+  free(g->col);
+  free(g->row);
+}
+
+/**
+ *  \brief Merge two sorted lists and credit every common element in c3
+ */
+uint32_t dist_intersect(
+  uint32_t const * const a,
+  uint32_t const         na,
+  uint32_t const * const b,
+  uint32_t const         nb,
+  int            * const c3
+) {
+  uint32_t k_pointer = 0, l_pointer = 0, value = 0;
+
+  while (k_pointer != na && l_pointer != nb) {
+    if (a[k_pointer] == b[l_pointer]) {
+      c3[a[k_pointer]]++;
+      value++;
+      k_pointer++;
+      l_pointer++;
+    }
+    else if (a[k_pointer] > b[l_pointer]) {
+      l_pointer++;
+    }
+    else {
+      k_pointer++;
+    }
+  }
+  return value;
+}
+
+/**
+ *  \brief Rank 0 prints the slowest rank's time and the total bytes per phase
+ *
+ *  Followed by the compute and communication time of every rank. The
+ *  imbalance is the slowest rank's compute time over the mean, time the
+ *  other ranks spend waiting for it shows up in their communication time.
+ */
+void dist_report(dist_stats const * const st, MPI_Comm const comm) {
+  double   time[DIST_PHASES];
+  uint64_t bytes[DIST_PHASES];
+  double   mine[2] = { st->time[DIST_COUNT], st->time[DIST_EXCHANGE] + st->time[DIST_REDUCE] };
+  double  *all = NULL;
+  int rank, size;
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  MPI_Reduce(st->time, time, DIST_PHASES, MPI_DOUBLE, MPI_MAX, 0, comm);
+  MPI_Reduce(st->bytes, bytes, DIST_PHASES, MPI_UINT64_T, MPI_SUM, 0, comm);
+  if (rank == 0) all = malloc(2 * size * sizeof(double));
+  MPI_Gather(mine, 2, MPI_DOUBLE, all, 2, MPI_DOUBLE, 0, comm);
+
+  if (rank != 0) return;
+  for (int p = 0; p < DIST_PHASES; p++)
+    printf("\nPhase %-8s time: %f  bytes: %llu", phase_name[p], time[p], (unsigned long long)bytes[p]);
+
+  double max = 0, mean = 0;
+  for (int r = 0; r < size; r++) {
+    printf("\nRank %d compute: %f  communication: %f", r, all[2*r], all[2*r+1]);
+    if (all[2*r] > max) max = all[2*r];
+    mean += all[2*r] / size;
+  }
+  printf("\nImbalance: %f", mean > 0 ? max / mean : 1.0);
+  free(all);
+}
@@ -0,0 +1,63 @@
+#ifndef DIST_H
+#define DIST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <mpi.h>
+
+/* Phases timed by the distributed engines */
+#define DIST_LOAD      0   /* rank 0 reads the file and scatters the edges */
+#define DIST_EXCHANGE  1   /* remote adjacency lists / matrix blocks */
+#define DIST_COUNT     2   /* local intersections */
+#define DIST_REDUCE    3   /* c3 and the global sum */
+#define DIST_PHASES    4
+
+typedef struct {
+  double   time[DIST_PHASES];   /*!< Seconds spent in every phase */
+  uint64_t bytes[DIST_PHASES];  /*!< Bytes this rank sent in every phase */
+} dist_stats;
+
+/* Strictly lower half L, partitioned by column blocks over the ranks */
+typedef struct {
+  int       rank;
+  int       size;
+  uint32_t  n;        /*!< Number of vertices */
+  uint32_t *bound;    /*!< Column boundaries of the ranks (size+1) */
+  uint32_t  first;    /*!< First own column */
+  uint32_t  last;     /*!< One past the last own column */
+  uint32_t  nnz;      /*!< Own nonzeros */
+  uint32_t *col;      /*!< Local column start indices (last-first+1) */
+  uint32_t *row;      /*!< Row indices, sorted per column */
+} dist_graph;
+
+int dist_read_mtx(
+  const char * const     filename,  /*!< Matrix Market file */
+  uint32_t            ** I,         /*!< Row indices (nz), allocated */
+  uint32_t            ** J,         /*!< Column indices (nz), allocated */
+  int            * const nz,
+  int            * const N
+);
+
+int dist_load_mtx(
+  const char * const     filename,  /*!< Matrix Market file, read by rank 0 */
+  MPI_Comm const         comm,
+  dist_graph           * g,
+  dist_stats           * st
+);
+
+uint32_t dist_owner(dist_graph const * const g, uint32_t const v);
+
+void dist_free(dist_graph *g);
+
+uint32_t dist_intersect(
+  uint32_t const * const a,         /*!< Sorted list */
+  uint32_t const         na,
+  uint32_t const * const b,         /*!< Sorted list */
+  uint32_t const         nb,
+  int            * const c3         /*!< Credited for every common element */
+);
+
+void dist_report(dist_stats const * const st, MPI_Comm const comm);
+
+#endif
@@ -0,0 +1,42 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "generate.h"
+
+int main(int argc, char *argv[])
+{
+    generate_params p;
+    uint32_t n, *row, *col;
+    struct timeval start, end;
+
+    if (argc < 3 || generate_parse(argv[1], &p) != 0)
+	{
+		fprintf(stderr, "Usage: %s [rmat:scale=S,edges=E,a=A,b=B,c=C,seed=X | er:n=N,p=P,seed=X | mycielskian:k=K] [output .mtx or .csc]\n", argv[0]);
+		exit(1);
+	}
+
+    gettimeofday(&start,NULL);
+    uint32_t nz = generate_edges(&p, &n, &row, &col);
+    gettimeofday(&end,NULL);
+    double duration = (end.tv_sec+(double)end.tv_usec/1000000) - (start.tv_sec+(double)start.tv_usec/1000000);
+    if (row == NULL) exit(1);
+
+    printf("Vertices: %u\n", n);
+    printf("Edges: %u\n", nz);
+    printf("Generate time: %f (%.1f M edges/s)\n", duration, duration > 0 ? nz / duration / 1e6 : 0.0);
+
+    /* The binary layout is the single shard file of triangle_ooc */
+    size_t len = strlen(argv[2]);
+    int failed = (len > 4 && strcmp(argv[2] + len - 4, ".csc") == 0)
+                 ? generate_write_csc(argv[2], n, nz, row, col)
+                 : generate_write_mtx(argv[2], n, nz, row, col);
+    if (failed) {
+        printf("Could not write %s\n", argv[2]);
+        exit(1);
+    }
+
+    free(row);
+    free(col);
+	return 0;
+}
@@ -0,0 +1,413 @@
+/**
+ *   \file generate.c
+ *   \brief Synthetic graphs for scale tests: R-MAT, G(n,p) and Mycielskian
+ *
+ *   Random numbers come from a counter based hash of the seed and the
+ *   edge (R-MAT) or column (G(n,p)) index, so every worker can draw its
+ *   share independently and a seed gives the same graph on any number of
+ *   threads. All graphs leave here in the form the file readers produce:
+ *   the strictly lower triangle, 0-based, no duplicates, sorted by column.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "generate.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Largest edge count kept, the engines double it for the full matrix */
+#define GENERATE_MAX_EDGES (UINT32_MAX / 2 - 1)
+
+/* Digit of the radix sort on packed edge keys */
+#define GENERATE_RADIX_BITS 11
+#define GENERATE_RADIX      (1u << GENERATE_RADIX_BITS)
+
+/* splitmix64 finalizer */
+static inline uint64_t mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+static inline double uniform(uint64_t bits) {
+  return (bits >> 11) * 0x1.0p-53;
+}
+
+/**
+ *  \brief A spec is a family name alone or followed by ':', anything else is a path
+ */
+int generate_is_spec(const char *source) {
+  static const char * const family[] = { "rmat", "kronecker", "er", "mycielskian" };
+  size_t len = strcspn(source, ":");
+  for (size_t f = 0; f < sizeof(family) / sizeof(family[0]); f++)
+    if (strlen(family[f]) == len && strncmp(source, family[f], len) == 0) return 1;
+  return 0;
+}
+
+/**
+ *  \brief Parse family:key=value,... such as rmat:scale=20,edges=16,seed=7
+ *
+ *  Keys: rmat/kronecker scale, edges, a, b, c; er n, p; mycielskian k;
+ *  seed for all. Returns 0 on success.
+ */
+int generate_parse(const char *spec, generate_params *p) {
+  char buffer[256], *rest;
+
+  p->kind = GENERATE_RMAT;
+  p->scale = 16;
+  p->edge_factor = 16;
+  p->a = 0.57;
+  p->b = 0.19;
+  p->c = 0.19;
+  p->n = 65536;
+  p->p = 0.001;
+  p->order = 10;
+  p->seed = 1;
+
+  snprintf(buffer, sizeof(buffer), "%s", spec);
+  rest = strchr(buffer, ':');
+  if (rest) *rest++ = '\0';
+  if (strcmp(buffer, "rmat") == 0 || strcmp(buffer, "kronecker") == 0) p->kind = GENERATE_RMAT;
+  else if (strcmp(buffer, "er") == 0)                                  p->kind = GENERATE_ER;
+  else if (strcmp(buffer, "mycielskian") == 0)                         p->kind = GENERATE_MYCIELSKIAN;
+  else return 1;
+
+  for (char *tok = rest ? strtok(rest, ",") : NULL; tok; tok = strtok(NULL, ",")) {
+    char *value = strchr(tok, '=');
+    if (value == NULL) return 1;
+    *value++ = '\0';
+    if (strcmp(tok, "scale") == 0)      p->scale = atoi(value);
+    else if (strcmp(tok, "edges") == 0) p->edge_factor = atoi(value);
+    else if (strcmp(tok, "a") == 0)     p->a = atof(value);
+    else if (strcmp(tok, "b") == 0)     p->b = atof(value);
+    else if (strcmp(tok, "c") == 0)     p->c = atof(value);
+    else if (strcmp(tok, "n") == 0)     p->n = strtoul(value, NULL, 10);
+    else if (strcmp(tok, "p") == 0)     p->p = atof(value);
+    else if (strcmp(tok, "k") == 0)     p->order = atoi(value);
+    else if (strcmp(tok, "seed") == 0)  p->seed = strtoull(value, NULL, 10);
+    else return 1;
+  }
+  if (p->scale < 1 || p->scale > 31 || p->a < 0 || p->b < 0 || p->c < 0 || p->a + p->b + p->c > 1) return 1;
+  if (p->order < 2 || p->order > 24) return 1;
+  return 0;
+}
+
+/* Bits of a vertex id in a packed edge key */
+static uint32_t id_bits(uint32_t const n) {
+  uint32_t bits = 1;
+  while (bits < 32 && (1ULL << bits) < n) bits++;
+  return bits;
+}
+
+/* Smaller end point in the high half, so keys sort by column then row; loops sort last */
+static inline uint64_t edge_key(uint32_t u, uint32_t v, uint32_t const bits) {
+  if (u == v) return (1ULL << (2 * bits)) - 1;
+  return u < v ? ((uint64_t)u << bits) | v : ((uint64_t)v << bits) | u;
+}
+
+/* Parallel LSD radix sort of the low bits of every key */
+static void radix_sort(uint64_t * const key, uint64_t const m, uint32_t const bits) {
+  uint64_t *from = key, *to = malloc((m + 1) * sizeof(uint64_t)), *spare = to;
+  uint64_t *count = NULL;
+
+  for (uint32_t shift = 0; shift < bits; shift += GENERATE_RADIX_BITS) {
+    #pragma omp parallel
+    {
+      int t = 0, T = 1;
+#ifdef _OPENMP
+      t = omp_get_thread_num();
+      T = omp_get_num_threads();
+#endif
+      #pragma omp single
+      count = calloc((size_t)T * GENERATE_RADIX, sizeof(uint64_t));
+
+      uint64_t first = m * t / T, last = m * (t + 1) / T;
+      uint64_t *mine = count + (size_t)t * GENERATE_RADIX;
+      for (uint64_t e = first; e < last; e++) mine[(from[e] >> shift) & (GENERATE_RADIX - 1)]++;
+      #pragma omp barrier
+
+      /* Digit major, thread minor, so every thread keeps its order within a digit */
+      #pragma omp single
+      {
+        uint64_t offset = 0;
+        for (uint32_t d = 0; d < GENERATE_RADIX; d++)
+          for (int w = 0; w < T; w++) {
+            uint64_t c = count[(size_t)w * GENERATE_RADIX + d];
+            count[(size_t)w * GENERATE_RADIX + d] = offset;
+            offset += c;
+          }
+      }
+      for (uint64_t e = first; e < last; e++) to[mine[(from[e] >> shift) & (GENERATE_RADIX - 1)]++] = from[e];
+    }
+    free(count);
+    uint64_t *swap = from;
+    from = to;
+    to = swap;
+  }
+  if (from != key) memcpy(key, from, m * sizeof(uint64_t));
+  free(spare);
+}
+
+/**
+ *  \brief Turn packed edge keys into the strictly lower triangle sorted by column
+ *
+ *  Drops self loops and duplicates. Returns the number of edges left.
+ */
+static uint32_t canonical(
+  uint32_t const         n,
+  uint64_t const         m,
+  uint64_t       * const key,       /*!< edge_key of every edge, sorted in place */
+  uint32_t            ** out_row,
+  uint32_t            ** out_col
+) {
+  uint32_t bits = id_bits(n);
+  uint64_t loop = (1ULL << (2 * bits)) - 1, mask = (1ULL << bits) - 1;
+  int parts = 1;
+
+  radix_sort(key, m, 2 * bits);
+#ifdef _OPENMP
+  parts = omp_get_max_threads();
+#endif
+
+  /* Every part keeps the keys that differ from their predecessor */
+  uint64_t *kept = calloc(parts + 1, sizeof(uint64_t));
+  #pragma omp parallel for num_threads(parts)
+  for (int t = 0; t < parts; t++) {
+    for (uint64_t e = m * t / parts; e < m * (t + 1) / parts; e++)
+      if (key[e] != loop && (e == 0 || key[e] != key[e-1])) kept[t+1]++;
+  }
+  for (int t = 0; t < parts; t++) kept[t+1] += kept[t];
+
+  uint32_t nz = kept[parts];
+  *out_row = malloc((2 * (size_t)nz + 1) * sizeof(uint32_t));
+  *out_col = malloc((2 * (size_t)nz + 1) * sizeof(uint32_t));
+  #pragma omp parallel for num_threads(parts)
+  for (int t = 0; t < parts; t++) {
+    uint64_t q = kept[t];
+    for (uint64_t e = m * t / parts; e < m * (t + 1) / parts; e++) {
+      if (key[e] == loop || (e > 0 && key[e] == key[e-1])) continue;
+      (*out_row)[q] = key[e] & mask;
+      (*out_col)[q++] = key[e] >> bits;
+    }
+  }
+
+  free(kept);
+  return nz;
+}
+
+/* Every edge descends scale levels, 16 random bits pick the quadrant of a level */
+static uint32_t rmat(generate_params const * const p, uint32_t **row, uint32_t **col) {
+  uint32_t n = 1u << p->scale;
+  uint64_t m = (uint64_t)p->edge_factor << p->scale;
+  uint32_t ta = p->a * 65536, tab = (p->a + p->b) * 65536, tabc = (p->a + p->b + p->c) * 65536;
+  uint64_t base = mix(p->seed);
+
+  uint32_t bits = id_bits(n);
+  uint64_t *key = malloc((m + 1) * sizeof(uint64_t));
+  #pragma omp parallel for schedule(static)
+  for (uint64_t e = 0; e < m; e++) {
+    uint32_t r = 0, c = 0;
+    uint64_t random = 0;
+    for (uint32_t l = 0; l < p->scale; l++) {
+      if (l % 4 == 0) random = mix(base ^ (e << 3) ^ (l / 4));
+      uint32_t u = random & 0xffff;
+      random >>= 16;
+      /* a: neither bit, b: column bit, c: row bit, d: both */
+      r = (r << 1) | (u >= tab);
+      c = (c << 1) | ((u >= ta) ^ (u >= tab) ^ (u >= tabc));
+    }
+    key[e] = edge_key(r, c, bits);
+  }
+
+  uint32_t nz = canonical(n, m, key, row, col);
+  free(key);
+  return nz;
+}
+
+/* Rows of column j in G(n,p), drawn by geometric skips over j+1..n-1 */
+static uint32_t er_column(
+  generate_params const * const p,
+  uint32_t const         j,
+  double const           log_q,
+  uint32_t       * const out
+) {
+  uint32_t count = 0;
+  uint64_t state = mix(mix(p->seed) ^ j);
+
+  if (p->p >= 1) {
+    for (uint32_t i = j + 1; i < p->n; i++) if (out) out[count++] = i; else count++;
+    return count;
+  }
+  if (p->p <= 0) return 0;
+  for (uint64_t i = j;;) {
+    state = mix(state);
+    i += 1 + (uint64_t)floor(log(1 - uniform(state)) / log_q);
+    if (i >= p->n) break;
+    if (out) out[count] = i;
+    count++;
+  }
+  return count;
+}
+
+static uint32_t erdos_renyi(generate_params const * const p, uint32_t **row, uint32_t **col) {
+  uint32_t n = p->n;
+  double log_q = log(1 - p->p);
+  uint32_t *start = malloc(((size_t)n + 1) * sizeof(uint32_t));
+  uint64_t total = 0;
+
+  /* Count first, then draw the same numbers again into place */
+  start[0] = 0;
+  #pragma omp parallel for schedule(dynamic, 256) reduction(+:total)
+  for (uint32_t j = 0; j < n; j++) {
+    start[j+1] = er_column(p, j, log_q, NULL);
+    total += start[j+1];
+  }
+  if (total > GENERATE_MAX_EDGES) {
+    fprintf(stderr, "G(%u, %g) has %llu edges, too many\n", n, p->p, (unsigned long long)total);
+    free(start);
+    return 0;
+  }
+  for (uint32_t j = 0; j < n; j++) start[j+1] += start[j];
+
+  uint32_t nz = start[n];
+  *row = malloc((2 * (size_t)nz + 1) * sizeof(uint32_t));
+  *col = malloc((2 * (size_t)nz + 1) * sizeof(uint32_t));
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (uint32_t j = 0; j < n; j++) {
+    er_column(p, j, log_q, *row + start[j]);
+    for (uint32_t q = start[j]; q < start[j+1]; q++) (*col)[q] = j;
+  }
+  free(start);
+  return nz;
+}
+
+/*
+ *  M(G) adds a twin u_i for every vertex v_i, adjacent to the neighbours of
+ *  v_i, and a vertex w adjacent to all twins. Starting from K2 the k-th
+ *  graph has 3*2^(k-2)-1 vertices and is triangle free.
+ */
+static uint32_t mycielskian(generate_params const * const p, uint32_t *n, uint32_t **row, uint32_t **col) {
+  uint64_t vertices = 2, edges = 1;
+  for (uint32_t k = 2; k < p->order; k++) {
+    edges = 3 * edges + vertices;
+    vertices = 2 * vertices + 1;
+  }
+  if (edges > GENERATE_MAX_EDGES) {
+    fprintf(stderr, "Mycielskian %u has %llu edges, too many\n", p->order, (unsigned long long)edges);
+    return 0;
+  }
+
+  uint32_t *raw_row = malloc((edges + 1) * sizeof(uint32_t));
+  uint32_t *raw_col = malloc((edges + 1) * sizeof(uint32_t));
+  uint32_t v = 2, m = 1;
+  raw_row[0] = 1;
+  raw_col[0] = 0;
+  for (uint32_t k = 2; k < p->order; k++) {
+    #pragma omp parallel for
+    for (uint32_t e = 0; e < m; e++) {
+      raw_row[m + 2*e] = v + raw_row[e];
+      raw_col[m + 2*e] = raw_col[e];
+      raw_row[m + 2*e + 1] = v + raw_col[e];
+      raw_col[m + 2*e + 1] = raw_row[e];
+    }
+    #pragma omp parallel for
+    for (uint32_t i = 0; i < v; i++) {
+      raw_row[3*m + i] = 2*v;
+      raw_col[3*m + i] = v + i;
+    }
+    m = 3*m + v;
+    v = 2*v + 1;
+  }
+
+  uint32_t bits = id_bits(v);
+  uint64_t *key = malloc(((uint64_t)m + 1) * sizeof(uint64_t));
+  #pragma omp parallel for
+  for (uint32_t e = 0; e < m; e++) key[e] = edge_key(raw_row[e], raw_col[e], bits);
+  free(raw_row);
+  free(raw_col);
+
+  *n = v;
+  uint32_t nz = canonical(v, m, key, row, col);
+  free(key);
+  return nz;
+}
+
+/**
+ *  \brief Generate the graph of p, in parallel when built with OpenMP
+ *
+ *  Returns the number of edges, 0 if the graph would not fit.
+ */
+uint32_t generate_edges(
+  generate_params const * const p,
+  uint32_t       * const n,
+  uint32_t            ** row,
+  uint32_t            ** col
+) {
+  *row = *col = NULL;
+  switch (p->kind) {
+    case GENERATE_ER:
+      *n = p->n;
+      return erdos_renyi(p, row, col);
+    case GENERATE_MYCIELSKIAN:
+      return mycielskian(p, n, row, col);
+    default:
+      *n = 1u << p->scale;
+      if (((uint64_t)p->edge_factor << p->scale) > GENERATE_MAX_EDGES) {
+        fprintf(stderr, "R-MAT scale %u with %u edges per vertex is too large\n", p->scale, p->edge_factor);
+        return 0;
+      }
+      return rmat(p, row, col);
+  }
+}
+
+int generate_write_mtx(
+  const char * const     filename,
+  uint32_t const         n,
+  uint32_t const         nz,
+  uint32_t const * const row,
+  uint32_t const * const col
+) {
+  FILE *f = fopen(filename, "w");
+  if (f == NULL) return 1;
+
+  setvbuf(f, NULL, _IOFBF, 1 << 20);
+  fprintf(f, "%%%%MatrixMarket matrix coordinate pattern symmetric\n");
+  fprintf(f, "%u %u %u\n", n, n, nz);
+  for (uint32_t e = 0; e < nz; e++) fprintf(f, "%u %u\n", row[e] + 1, col[e] + 1);
+  fclose(f);
+  return 0;
+}
+
+/**
+ *  \brief Write L in the shard layout of triangle_ooc, one shard for all columns
+ *
+ *  Header first, last, nnz, then the column pointers and the rows.
+ */
+int generate_write_csc(
+  const char * const     filename,
+  uint32_t const         n,
+  uint32_t const         nz,
+  uint32_t const * const row,
+  uint32_t const * const col
+) {
+  FILE *f = fopen(filename, "wb");
+  if (f == NULL) return 1;
+
+  uint32_t *pointer = calloc((size_t)n + 1, sizeof(uint32_t));
+  for (uint32_t e = 0; e < nz; e++) pointer[col[e] + 1]++;
+  for (uint32_t j = 0; j < n; j++) pointer[j+1] += pointer[j];
+
+  uint32_t header[3] = { 0, n, nz };
+  fwrite(header, sizeof(uint32_t), 3, f);
+  fwrite(pointer, sizeof(uint32_t), (size_t)n + 1, f);
+  fwrite(row, sizeof(uint32_t), nz, f);
+  fclose(f);
+  free(pointer);
+  return 0;
+}
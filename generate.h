@@ -0,0 +1,51 @@
+#ifndef GENERATE_H
+#define GENERATE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Graph families */
+#define GENERATE_RMAT        0   /* recursive matrix, skewed like Kronecker graphs */
+#define GENERATE_ER          1   /* Erdos-Renyi G(n,p) */
+#define GENERATE_MYCIELSKIAN 2   /* triangle free, the SuiteSparse mycielskian set */
+
+typedef struct {
+  int       kind;         /*!< GENERATE_* */
+  uint32_t  scale;        /*!< R-MAT: 2^scale vertices */
+  uint32_t  edge_factor;  /*!< R-MAT: edges drawn per vertex */
+  double    a, b, c;      /*!< R-MAT: quadrant probabilities, d = 1-a-b-c */
+  uint32_t  n;            /*!< G(n,p): vertices */
+  double    p;            /*!< G(n,p): edge probability */
+  uint32_t  order;        /*!< Mycielskian: k, 3*2^(k-2)-1 vertices */
+  uint64_t  seed;         /*!< Same seed, same graph for any thread count */
+} generate_params;
+
+int generate_is_spec(const char *source);
+
+int generate_parse(const char *spec, generate_params *p);
+
+uint32_t generate_edges(
+  generate_params const * const p,
+  uint32_t       * const n,         /*!< Number of vertices, out */
+  uint32_t            ** row,       /*!< Strictly lower COO rows, room for 2*nz, out */
+  uint32_t            ** col        /*!< COO columns, sorted, room for 2*nz, out */
+);
+
+int generate_write_mtx(
+  const char * const     filename,
+  uint32_t const         n,
+  uint32_t const         nz,
+  uint32_t const * const row,
+  uint32_t const * const col
+);
+
+int generate_write_csc(
+  const char * const     filename,
+  uint32_t const         n,
+  uint32_t const         nz,
+  uint32_t const * const row,
+  uint32_t const * const col        /*!< Sorted by column, as generate_edges leaves it */
+);
+
+#endif
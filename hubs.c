@@ -0,0 +1,133 @@
+/**
+ *   \file hubs.c
+ *   \brief Dot product engine with bitmaps for the hub columns
+ *
+ *   On power-law graphs most intersections of the dot product have a
+ *   hub at one end, and merging a list of thousands for a partner of
+ *   ten is almost all wasted steps. The heaviest columns get a bitmap
+ *   over all n rows, built once, and an intersection with a hub probes
+ *   the bitmap with the other list: deg(other) lookups instead of
+ *   deg(hub) + deg(other) merge steps. Two hubs probe the heavier one
+ *   with the lighter list, ordinary pairs keep the sorted-list merge.
+ *   The hubs are taken heaviest first until the budget is used up.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "spgemm.h"
+#include "work.h"
+#include "hubs.h"
+
+typedef struct {
+  uint32_t vertex;
+  uint32_t degree;
+} hub_candidate;
+
+static int heavier(const void *a, const void *b) {
+  uint32_t x = ((hub_candidate const *)a)->degree, y = ((hub_candidate const *)b)->degree;
+  return (x < y) - (x > y);
+}
+
+/**
+ *  \brief Pick the hubs and fill their bitmaps
+ *
+ *  Returns a hub_bitmap without hubs when no column is heavy enough or
+ *  not even one bitmap fits, the engine then runs the plain dot product.
+ */
+hub_bitmap *hubs_build(
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         n,
+  size_t const           budget
+) {
+  hub_bitmap *hb = calloc(1, sizeof(hub_bitmap));
+  double mean = n ? (double)cscColumn[n] / n : 0;
+  uint32_t candidates = 0;
+
+  hb->words = (n + 63) / 64;
+  hb->slot = malloc((size_t)n * sizeof(uint32_t));
+  for (uint32_t v = 0; v < n; v++) hb->slot[v] = HUBS_NONE;
+
+  // ----- heavy columns, heaviest first, as many as fit
+  hub_candidate *cand = malloc(((size_t)n + 1) * sizeof(hub_candidate));
+  for (uint32_t v = 0; v < n; v++) {
+    uint32_t degree = cscColumn[v+1] - cscColumn[v];
+    if (degree > 0 && degree >= HUBS_MIN_SKEW * mean) cand[candidates++] = (hub_candidate){ v, degree };
+  }
+  qsort(cand, candidates, sizeof(hub_candidate), heavier);
+  size_t fit = hb->words ? budget / (hb->words * sizeof(uint64_t)) : 0;
+  hb->hubs = candidates < fit ? candidates : (uint32_t)fit;
+  hb->bytes = (size_t)hb->hubs * hb->words * sizeof(uint64_t);
+  hb->min_degree = hb->hubs ? cand[hb->hubs - 1].degree : 0;
+
+  // ----- one bitmap per hub, each hub fills its own
+  hb->bits = calloc((size_t)hb->hubs * hb->words + 1, sizeof(uint64_t));
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (uint32_t s = 0; s < hb->hubs; s++) {
+    uint32_t v = cand[s].vertex;
+    uint64_t *bits = hb->bits + (size_t)s * hb->words;
+    hb->slot[v] = s;
+    for (uint32_t p = cscColumn[v]; p < cscColumn[v+1]; p++)
+      bits[cscRow[p] / 64] |= 1ull << (cscRow[p] % 64);
+  }
+  free(cand);
+
+  // ----- intersections the bitmaps will answer
+  uint64_t probed = 0;
+  #pragma omp parallel for schedule(dynamic, 1024) reduction(+:probed)
+  for (uint32_t j = 0; j < n; j++)
+    for (uint32_t p = cscColumn[j]; p < cscColumn[j+1]; p++)
+      probed += hb->slot[j] != HUBS_NONE || hb->slot[cscRow[p]] != HUBS_NONE;
+  hb->share = cscColumn[n] ? (double)probed / cscColumn[n] : 0;
+  return hb;
+}
+
+void hubs_free(hub_bitmap *hb) {
+  if (hb == NULL) return;
+  free(hb->slot);
+  free(hb->bits);
+  free(hb);
+}
+
+/* Entries of the list set in the bitmap */
+static inline uint32_t probe(uint64_t const * const bits, uint32_t const * const list, uint32_t const length) {
+  uint32_t count = 0;
+
+  for (uint32_t k = 0; k < length; k++)
+    count += (bits[list[k] / 64] >> (list[k] % 64)) & 1;
+  WORK_ADD(intersections, 1);
+  WORK_ADD(compared, length);
+  WORK_ADD(hits, count);
+  WORK_SIZE(length);
+  return count;
+}
+
+/* C(i,j) = |A(:,i) .* A(:,j)| for every nonzero (i,j) of the column range */
+void hubs_dot(
+  hub_bitmap     const * const hb,
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         start,
+  uint32_t const         end,
+  uint32_t       * const c_values
+) {
+  for (uint32_t j = start; j < end; j++) {
+    uint32_t slot_j = hb->slot[j], degree_j = cscColumn[j+1] - cscColumn[j];
+
+    for (uint32_t p = cscColumn[j]; p < cscColumn[j+1]; p++) {
+      uint32_t i = cscRow[p], slot_i = hb->slot[i], degree_i = cscColumn[i+1] - cscColumn[i];
+
+      if (slot_j != HUBS_NONE && (slot_i == HUBS_NONE || degree_j >= degree_i))
+        c_values[p] = probe(hb->bits + (size_t)slot_j * hb->words, cscRow + cscColumn[i], degree_i);
+      else if (slot_i != HUBS_NONE)
+        c_values[p] = probe(hb->bits + (size_t)slot_i * hb->words, cscRow + cscColumn[j], degree_j);
+      else
+        c_values[p] = spgemm_intersect(cscRow, cscColumn, i, j);
+    }
+  }
+}
@@ -0,0 +1,43 @@
+#ifndef HUBS_H
+#define HUBS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* A vertex is a hub from this multiple of the mean degree on */
+#define HUBS_MIN_SKEW 8
+/* Upper bound for the bitmaps of all hubs together (bytes) */
+#define HUBS_BUDGET (64u << 20)
+
+#define HUBS_NONE UINT32_MAX
+
+typedef struct {
+  uint32_t   hubs;       /*!< Vertices with a bitmap */
+  uint32_t   words;      /*!< 64 bit words per bitmap, n/64 rounded up */
+  uint32_t   min_degree; /*!< Degree of the lightest hub */
+  uint32_t  *slot;       /*!< Bitmap of every vertex, HUBS_NONE for ordinary ones */
+  uint64_t  *bits;       /*!< Bitmap of slot s at s * words */
+  size_t     bytes;      /*!< Memory of the bitmaps */
+  double     share;      /*!< Nonzeros with a hub at one end */
+} hub_bitmap;
+
+hub_bitmap *hubs_build(
+  uint32_t const * const cscRow,     /*!< CSC row indices of the full matrix */
+  uint32_t const * const cscColumn,  /*!< CSC column start indices */
+  uint32_t const         n,          /*!< Number of rows/columns */
+  size_t const           budget      /*!< Bytes the bitmaps may take */
+);
+
+void hubs_free(hub_bitmap *hb);
+
+void hubs_dot(
+  hub_bitmap     const * const hb,
+  uint32_t const * const cscRow,     /*!< CSC row indices, sorted per column */
+  uint32_t const * const cscColumn,
+  uint32_t const         start,      /*!< First column to compute */
+  uint32_t const         end,        /*!< One past the last column */
+  uint32_t       * const c_values    /*!< C value of every nonzero */
+);
+
+#endif
@@ -0,0 +1,786 @@
+/**
+ *   \file libtriangle.c
+ *   \brief Loading, CSC construction and engine dispatch shared by every backend
+ *
+ *   An engine is written once as a body over a range of work items
+ *   (columns, tiles, tasks or nonzero blocks) that only touches the
+ *   workspace of its worker. A backend only decides which worker runs
+ *   which range, so every engine runs on every backend and a fix to an
+ *   engine lands everywhere at once. Nothing here is global, two counts
+ *   may run side by side on different graphs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include "mmio.h"
+#include "coo2csc.h"
+#include "reorder.h"
+#include "spgemm.h"
+#include "lowertri.h"
+#include "tiling.h"
+#include "tasks.h"
+#include "affinity.h"
+#include "generate.h"
+#include "work.h"
+#include "stats.h"
+#include "bitmatrix.h"
+#include "hubs.h"
+#include "libtriangle.h"
+
+/*****************************************************************************/
+/*                                  options                                  */
+/*****************************************************************************/
+
+void triangle_default_options(triangle_options *opt) {
+  opt->engine    = TRIANGLE_AUTO;
+  opt->backend   = TRIANGLE_SEQ;
+  opt->workers   = 1;
+  opt->reorder   = REORDER_NONE;
+  opt->tile_size = 0;
+  opt->curve     = TILING_HILBERT;
+  opt->layout    = AFFINITY_NONE;
+  opt->placement = AFFINITY_TOUCH;
+  opt->chunks    = 0;
+  opt->prune     = 0;
+  opt->profile   = NULL;
+}
+
+int triangle_parse_engine(const char *name) {
+  if (name != NULL && strcmp(name, "v3") == 0) return TRIANGLE_V3;
+  if (name != NULL && strcmp(name, "auto") == 0) return TRIANGLE_AUTO;
+  if (name != NULL && strcmp(name, "bitmap") == 0) return TRIANGLE_BITMAP;
+  if (name != NULL && strcmp(name, "hubs") == 0) return TRIANGLE_HUBS;
+  if (name != NULL && strcmp(name, "packed") == 0) return TRIANGLE_PACKED;
+  if (name != NULL && strcmp(name, "v4") == 0) return SPGEMM_AUTO;
+  return spgemm_parse_engine(name);
+}
+
+const char *triangle_engine_name(int engine) {
+  if (engine == TRIANGLE_V3)   return "v3";
+  if (engine == TRIANGLE_AUTO) return "auto";
+  if (engine == TRIANGLE_BITMAP) return "bitmap";
+  if (engine == TRIANGLE_HUBS) return "hubs";
+  if (engine == TRIANGLE_PACKED) return "packed";
+  if (engine == SPGEMM_AUTO)   return "v4";
+  return spgemm_engine_name(engine);
+}
+
+int triangle_parse_backend(const char *name) {
+  if (name == NULL || strcmp(name, "seq") == 0) return TRIANGLE_SEQ;
+  if (strcmp(name, "openmp") == 0)              return TRIANGLE_OPENMP;
+  if (strcmp(name, "cilk") == 0)                return TRIANGLE_CILK;
+  if (strcmp(name, "pthreads") == 0)            return TRIANGLE_PTHREADS;
+  return -1;
+}
+
+const char *triangle_backend_name(int backend) {
+  switch (backend) {
+    case TRIANGLE_OPENMP:   return "openmp";
+    case TRIANGLE_CILK:     return "cilk";
+    case TRIANGLE_PTHREADS: return "pthreads";
+    default:                return "seq";
+  }
+}
+
+/*****************************************************************************/
+/*                              graph building                               */
+/*****************************************************************************/
+
+/**
+ *  \brief Load a graph from a generator spec, a binary .csc file or Matrix Market
+ *
+ *  The source is tried as a file first and only then as a spec. Returns 0
+ *  on success.
+ */
+int triangle_load(const char * const source, triangle_options const * opt, triangle_coo *coo) {
+  size_t len = strlen(source);
+
+  FILE *f = fopen(source, "r");
+  int exists = f != NULL;
+  if (f) fclose(f);
+
+  /* A file of that name wins over a spec */
+  if (!exists && generate_is_spec(source)) {
+    generate_params p;
+    memset(coo, 0, sizeof(triangle_coo));
+    if (generate_parse(source, &p) != 0) return 1;
+    profile_begin(opt->profile);
+    coo->nz = generate_edges(&p, &coo->n, &coo->row, &coo->col);
+    coo->canonical = 1;   /* the generators sort and deduplicate their edges */
+    profile_end(opt->profile, PROFILE_PARSE);
+    return coo->row == NULL;
+  }
+  if (len > 4 && strcmp(source + len - 4, ".csc") == 0) return triangle_load_csc(source, coo, opt->profile);
+  return triangle_load_mtx(source, coo, opt->profile);
+}
+
+/**
+ *  \brief Read a Matrix Market file holding one triangle of a symmetric matrix
+ *
+ *  Returns 0 on success and 1 when the file is short or an entry does not
+ *  parse. The values of a non-pattern file are skipped, indices outside
+ *  1..N are left for canon_coo to drop.
+ */
+int triangle_load_mtx(const char * const filename, triangle_coo *coo, profile *prof) {
+  MM_typecode matcode;
+  uint32_t M, N, nz;
+  double val;
+  FILE *f;
+
+  memset(coo, 0, sizeof(triangle_coo));
+  profile_begin(prof);
+  if ((f = fopen(filename, "r")) == NULL) return 1;
+  if (mm_read_banner(f, &matcode) != 0 ||
+      (mm_is_complex(matcode) && mm_is_matrix(matcode) && mm_is_sparse(matcode)) ||
+      mm_read_mtx_crd_size(f, &M, &N, &nz) != 0 || M != N) {
+    fclose(f);
+    return 1;
+  }
+
+  coo->n = N;
+  coo->nz = nz;
+  coo->general = !mm_is_symmetric(matcode);
+  coo->row = malloc(((size_t)nz + 1) * sizeof(uint32_t));
+  coo->col = malloc(((size_t)nz + 1) * sizeof(uint32_t));
+  profile_end(prof, PROFILE_READ);
+  int pattern = mm_is_pattern(matcode), bad = 0;
+  for (uint32_t i = 0; i < nz && !bad; i++) {
+    if (pattern) bad = fscanf(f, "%u %u\n", &coo->row[i], &coo->col[i]) != 2;
+    else         bad = fscanf(f, "%u %u %lg\n", &coo->row[i], &coo->col[i], &val) != 3;
+    coo->row[i]--;  /* adjust from 1-based to 0-based */
+    coo->col[i]--;
+  }
+  if (f != stdin) fclose(f);
+  profile_end(prof, PROFILE_PARSE);
+  if (bad) triangle_coo_free(coo);
+  return bad;
+}
+
+/**
+ *  \brief Read L from the binary layout written by gen, header first, last, nnz
+ *
+ *  Returns 0 on success and 1 on a short read, column pointers that do
+ *  not run from 0 to nnz without decreasing, or a row of n or more. A
+ *  file whose columns hold strictly increasing rows below the diagonal,
+ *  as gen writes them, is marked canonical.
+ */
+int triangle_load_csc(const char * const filename, triangle_coo *coo, profile *prof) {
+  uint32_t header[3];
+  FILE *f;
+
+  memset(coo, 0, sizeof(triangle_coo));
+  profile_begin(prof);
+  if ((f = fopen(filename, "rb")) == NULL) return 1;
+  if (fread(header, sizeof(uint32_t), 3, f) != 3 || header[0] != 0) {
+    fclose(f);
+    return 1;
+  }
+
+  uint32_t n = header[1], nz = header[2];
+  uint32_t *pointer = malloc(((size_t)n + 1) * sizeof(uint32_t));
+  coo->n = n;
+  coo->nz = nz;
+  coo->row = malloc(((size_t)nz + 1) * sizeof(uint32_t));
+  coo->col = malloc(((size_t)nz + 1) * sizeof(uint32_t));
+  int bad = fread(pointer, sizeof(uint32_t), (size_t)n + 1, f) != (size_t)n + 1 ||
+            fread(coo->row, sizeof(uint32_t), nz, f) != nz;
+  fclose(f);
+  profile_end(prof, PROFILE_READ);
+
+  /* Only a checked layout is scattered, the pointers index coo->col */
+  bad = bad || pointer[0] != 0 || pointer[n] != nz;
+  for (uint32_t j = 0; j < n && !bad; j++) bad = pointer[j+1] < pointer[j];
+  for (uint32_t p = 0; p < nz && !bad; p++) bad = coo->row[p] >= n;
+  if (!bad) {
+    int canonical = 1;
+    for (uint32_t j = 0; j < n; j++)
+      for (uint32_t p = pointer[j]; p < pointer[j+1]; p++) {
+        coo->col[p] = j;
+        canonical &= coo->row[p] > (p == pointer[j] ? j : coo->row[p-1]);
+      }
+    coo->canonical = canonical;
+  }
+  free(pointer);
+  profile_end(prof, PROFILE_PARSE);
+  if (bad) triangle_coo_free(coo);
+  return bad;
+}
+
+void triangle_coo_free(triangle_coo *coo) {
+  free(coo->row);
+  free(coo->col);
+  coo->row = coo->col = NULL;
+}
+
+/**
+ *  \brief Workers the backend of opt will run, -1 if it is not in this build
+ */
+int triangle_workers(triangle_options const * opt) {
+  switch (opt->backend) {
+    case TRIANGLE_OPENMP:   return triangle_workers_openmp(opt->workers);
+    case TRIANGLE_CILK:     return triangle_workers_cilk(opt->workers);
+    case TRIANGLE_PTHREADS: return triangle_workers_pthreads(opt->workers);
+    default:                return 1;
+  }
+}
+
+/* Appends a line to the explanation of the engine choice */
+static void because(triangle_graph *g, const char *format, ...) {
+  size_t used = strlen(g->reason);
+  va_list args;
+  va_start(args, format);
+  vsnprintf(g->reason + used, sizeof(g->reason) - used, format, args);
+  va_end(args);
+}
+
+/* The interleave policy only reaches pages not written yet, so the final arrays move once */
+static void interleave_csc(triangle_graph *g) {
+  size_t rows = (size_t)g->cscColumn[g->n] * sizeof(uint32_t), columns = ((size_t)g->n + 1) * sizeof(uint32_t);
+  uint32_t *row = malloc(rows + sizeof(uint32_t));
+  uint32_t *column = malloc(columns);
+  if (!affinity_interleave(row, rows) || !affinity_interleave(column, columns)) {
+    free(row);
+    free(column);
+    return;
+  }
+  memcpy(row, g->cscRow, rows);
+  memcpy(column, g->cscColumn, columns);
+  free(g->cscRow);
+  free(g->cscColumn);
+  g->cscRow = row;
+  g->cscColumn = column;
+  g->placement = AFFINITY_INTERLEAVE;
+}
+
+/**
+ *  \brief Cost model of TRIANGLE_AUTO, picks engine and grain from g->stats
+ *
+ *  Every engine gets an estimate of the entries it touches, from the
+ *  wedges W, the sum of squared degrees D = sum d^2 and the size of the
+ *  matrix, and the cheapest one whose memory fits is taken:
+ *
+ *    bitmap  nnz * n/64        one AND and popcount per word of two rows, when
+ *                              the graph is dense enough to be one block,
+ *                              else the merges of dot
+ *    lower   W/2 + nnz/2       a wedge is closed once, from its middle vertex
+ *    v3      W/2 * D/nnz / 2   the same wedges, each closing edge found by a scan
+ *    hubs    D                 probes into hub bitmaps instead of merges
+ *    v4      2D, D             merge of both lists per nonzero for dot, one
+ *                              accumulator visit per wedge for gustavson/hash
+ *
+ *  The budgets only rule engines out: copies of c3 per worker for v3, and
+ *  a marker on top for lower, must fit the dense budget of spgemm.h, the
+ *  bits of the bitmap and hub engines their own. Hubs are only an option
+ *  on skewed graphs, and spgemm_choose_engine picks the v4 accumulator.
+ */
+static void choose_engine(triangle_graph *g, int const workers) {
+  graph_stats const *s = &g->stats;
+  double budget = SPGEMM_DENSE_BUDGET;
+  double c3_bytes = (double)g->n * sizeof(int) * workers;
+  double hub_bytes = (double)(g->n + 63) / 64 * sizeof(uint64_t);
+  double squares = s->neighbour_degree * g->nnz;
+  int hubs = s->skew > TRIANGLE_HUB_SKEW;
+  int v4 = spgemm_choose_engine(g->n, g->nnz, workers);
+  int whole = s->density >= BITMATRIX_MIN_DENSITY;
+  struct { int engine; const char *out; double work; } option[] = {
+    { TRIANGLE_BITMAP, bitmatrix_bytes(g->n) > BITMATRIX_BUDGET ? "over budget" : NULL,
+                       whole ? (double)g->nnz * ((g->n + 63) / 64) : 2 * squares },
+    { SPGEMM_LOWER,    2 * c3_bytes > budget ? "over budget" : NULL, s->wedges / 2 + g->nnz / 2.0 },
+    { TRIANGLE_V3,     c3_bytes > budget ? "over budget" : NULL,     s->wedges / 2 * s->neighbour_degree / 2 },
+    { TRIANGLE_HUBS,   !hubs ? "no hubs" : hub_bytes > HUBS_BUDGET ? "over budget" : NULL, squares },
+    { v4,              NULL,                                         (v4 == SPGEMM_DOT ? 2 : 1) * squares },
+  };
+  int options = sizeof(option) / sizeof(option[0]), best = options - 1;
+
+  g->reason[0] = '\0';
+  because(g, "work:");
+  for (int o = 0; o < options; o++) {
+    if (option[o].out == NULL && option[o].work < option[best].work) best = o;
+    because(g, " %s %.3g%s%s%s", triangle_engine_name(option[o].engine), option[o].work,
+            option[o].out ? " (" : "", option[o].out ? option[o].out : "", option[o].out ? ")" : "");
+  }
+  because(g, "\n");
+  g->engine = option[best].engine;
+
+  switch (g->engine) {
+    case TRIANGLE_BITMAP:
+      because(g, "engine bitmap: density %.3f, rows of %u words AND and popcount instead of "
+                 "merging %.0f entries, %.1f MB of bits\n",
+              s->density, (g->n + 63) / 64, 2 * s->neighbour_degree, bitmatrix_bytes(g->n) / (1 << 20));
+      break;
+    case SPGEMM_LOWER:
+      because(g, "engine lower: %.3g wedges closed once each, c3 copies and markers of %d workers "
+                 "take %.1f MB of %.0f MB\n",
+              s->wedges, workers, 2 * c3_bytes / (1 << 20), budget / (1 << 20));
+      break;
+    case TRIANGLE_V3:
+      because(g, "engine v3: a neighbour degree of %.1f keeps the closing scans short, c3 copies "
+                 "take %.1f MB of %.0f MB\n",
+              s->neighbour_degree, c3_bytes / (1 << 20), budget / (1 << 20));
+      break;
+    case TRIANGLE_HUBS:
+      because(g, "engine hubs: skew %.0f, the heaviest columns get bitmaps of %.1f KB that the "
+                 "short lists probe\n",
+              s->skew, hub_bytes / 1024);
+      break;
+    default:
+      because(g, "engine %s: mean degree %.1f, %s accumulator\n",
+              spgemm_engine_name(g->engine), s->mean_degree,
+              g->engine == SPGEMM_DOT ? "no" : g->engine == SPGEMM_GUSTAVSON ? "dense" : "hashed");
+      break;
+  }
+
+  /* Columns of hubs are long, smaller chunks keep one from finishing last */
+  g->chunks = hubs ? 4 * TRIANGLE_CHUNKS_PER_WORKER : TRIANGLE_CHUNKS_PER_WORKER;
+  because(g, "grain: %u chunks per worker, skew %.1f%s\n", g->chunks, s->skew,
+          hubs ? " has hubs" : "");
+}
+
+/* Drops the entries of one half of a full CSC in place, keeping the order */
+static void keep_half(triangle_graph *g, int const below) {
+  uint32_t kept = 0, start = 0;
+
+  for (uint32_t i = 0; i < g->n; i++) {
+    uint32_t end = g->cscColumn[i+1];
+    g->cscColumn[i] = kept;
+    for (uint32_t p = start; p < end; p++) {
+      uint32_t r = g->cscRow[p];
+      if (below ? r > i : r < i) g->cscRow[kept++] = r;
+    }
+    start = end;
+  }
+  g->cscColumn[g->n] = kept;
+  g->nnz = kept;
+}
+
+/**
+ *  \brief Build the CSC the engine works on
+ *
+ *  The COO is made canonical first, see canon.c, whatever orientation,
+ *  order, diagonal, repeats or stray indices the file had, so that the
+ *  reordering only ever sees valid distinct edges. A COO whose loader
+ *  vouches for its order, the generators and a checked .csc file, skips
+ *  that pass. V3 walks the single stored
+ *  triangle, the lower engine the strictly lower half and all other
+ *  engines the full symmetric matrix. With opt->prune the full matrix is
+ *  peeled to its 2-core, see prune.c, before any half is cut. For
+ *  TRIANGLE_AUTO the full matrix is built, measured and cut down to the
+ *  half the chosen engine wants. AFFINITY_INTERLEAVE copies the final
+ *  arrays onto interleaved pages, g->placement tells whether it could.
+ */
+int triangle_build(
+  triangle_coo           * coo,
+  triangle_options const * opt,
+  triangle_graph         * g
+) {
+  profile *prof = opt->profile;
+  uint32_t n = coo->n, nz = coo->nz;
+  double start;
+
+  memset(g, 0, sizeof(triangle_graph));
+  g->n = g->vertices = n;
+  g->engine = opt->engine;
+
+  profile_begin(prof);
+
+  /* Every edge once below the diagonal, sorted, whatever the file held */
+  if (coo->canonical) {
+    g->canon.entries = g->canon.edges = nz;
+    g->canon.was_canonical = 1;
+  }
+  else nz = coo->nz = canon_coo(coo->row, coo->col, nz, n, &g->canon);
+  g->canon.general = coo->general;
+  profile_end(prof, PROFILE_CANON);
+
+  if (opt->reorder != REORDER_NONE) {
+    /* New labels flip and scatter the entries, canon_coo sorts them again */
+    canon_stats relabeled;
+    start = profile_now();
+    g->perm = reorder_coo(opt->reorder, coo->row, coo->col, nz, n);
+    canon_coo(coo->row, coo->col, nz, n, &relabeled);
+    g->reorder_time = profile_now() - start;
+    profile_end(prof, PROFILE_REORDER);
+  }
+
+  /* Pruning needs both halves to see every degree, the half is cut after */
+  int half = opt->engine == SPGEMM_LOWER || opt->engine == TRIANGLE_V3;
+  int full = !half || opt->prune;
+
+  /* The mirror goes straight into the CSC, the COO keeps one triangle */
+  g->cscRow = malloc(((full ? 2 : 1) * (size_t)nz + 1) * sizeof(uint32_t));
+  g->cscColumn = malloc((n + 1) * sizeof(uint32_t));
+  if (opt->engine == SPGEMM_LOWER && !full) {
+    g->nnz = lowertri_build(g->cscRow, g->cscColumn, coo->row, coo->col, nz, n);
+  }
+  else if (full) {
+    /* Sorted lower COO, so column c gets its rows below c, then above */
+    coo2csc_symmetric(g->cscRow, g->cscColumn, coo->col, coo->row, nz, n);
+    g->nnz = 2 * nz;
+  }
+  else {
+    /* V3 keeps the rows above the diagonal, column c gets the j < c */
+    coo2csc(g->cscRow, g->cscColumn, coo->col, coo->row, nz, n, 0);
+    g->nnz = nz;
+  }
+  profile_end(prof, PROFILE_CSC);
+
+  if (opt->prune) {
+    g->kept = prune_2core(g->cscRow, g->cscColumn, &g->n, &g->prune);
+    n = g->n;
+    g->nnz = g->cscColumn[n];
+    if (opt->engine == SPGEMM_LOWER)     keep_half(g, 1);
+    else if (opt->engine == TRIANGLE_V3) keep_half(g, 0);
+    profile_end(prof, PROFILE_PRUNE);
+  }
+
+  if (opt->engine == TRIANGLE_PACKED) {
+    g->packed = packed_build(g->cscRow, g->cscColumn, n);
+    free(g->cscRow);
+    g->cscRow = NULL;
+    profile_end(prof, PROFILE_CSC);
+  }
+
+  if (opt->engine == TRIANGLE_AUTO) {
+    int workers = triangle_workers(opt);
+    stats_compute(g->cscColumn, n, &g->stats);
+    choose_engine(g, workers > 0 ? workers : 1);
+    if (g->engine == SPGEMM_LOWER)     keep_half(g, 1);
+    else if (g->engine == TRIANGLE_V3) keep_half(g, 0);
+    profile_end(prof, PROFILE_STATS);
+  }
+
+  if (opt->placement == AFFINITY_INTERLEAVE && g->cscRow != NULL) {
+    interleave_csc(g);
+    profile_end(prof, PROFILE_CSC);
+  }
+  return 0;
+}
+
+void triangle_graph_free(triangle_graph *g) {
+  free(g->cscRow);
+  free(g->cscColumn);
+  free(g->perm);
+  free(g->kept);
+  packed_free(g->packed);
+  memset(g, 0, sizeof(triangle_graph));
+}
+
+/*****************************************************************************/
+/*                                  engines                                  */
+/*****************************************************************************/
+
+typedef struct {
+  triangle_graph const *g;
+  int                   engine;
+  uint32_t             *c_values;   /* C = A.*(A*A) engines */
+  int                 **local_c3;   /* v3 and lower, one copy per worker */
+  uint64_t             *found;      /* v3, triangles per worker */
+  uint32_t            **marker;     /* lower */
+  spgemm_workspace    **ws;         /* gustavson and hash */
+  tiling_schedule      *schedule;   /* tiled */
+  tasks_plan           *plan;       /* tasks */
+  bitmatrix            *bits;       /* bitmap */
+  hub_bitmap           *hubs;       /* hubs */
+  uint32_t            **rows;       /* packed, one decoded column per worker */
+  triangle_body         body;       /* engine body behind timed_body */
+  int                   columns;    /* items are columns of cscRow, so their traffic can be modeled */
+  profile              *prof;
+} count_job;
+
+/* V3: for every edge (row1, i) look up the closing edge of each wedge */
+static uint64_t v3_count_range(
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         start,
+  uint32_t const         end,
+  int            * const c3
+) {
+  uint64_t sum = 0;
+
+  for (uint32_t i = (start > 0 ? start : 1); i < end; i++) {
+    for (uint32_t j = cscColumn[i]; j < cscColumn[i+1]; j++) {
+      uint32_t row1 = cscRow[j], col1 = i, col2 = row1;
+      for (uint32_t k = cscColumn[row1]; k < cscColumn[row1+1]; k++) {
+        uint32_t row2 = cscRow[k];
+        uint32_t look = row2 > col1 ? row2 : col1;
+        uint32_t want = row2 > col1 ? col1 : row2;
+        for (uint32_t l = cscColumn[look]; l < cscColumn[look+1]; l++) {
+          if (cscRow[l] == want) {
+            sum++;
+            c3[col1]++;
+            c3[row2]++;
+            c3[col2]++;
+            WORK_ADD(hits, 1);
+          }
+        }
+        WORK_ADD(wedges, 1);
+        WORK_ADD(closure_scans, 1);
+        WORK_ADD(compared, cscColumn[look+1] - cscColumn[look]);
+        WORK_SIZE(cscColumn[look+1] - cscColumn[look]);
+      }
+    }
+  }
+  return sum;
+}
+
+static void body_v3(void *arg, int worker, uint32_t first, uint32_t last) {
+  count_job *job = arg;
+  job->found[worker] += v3_count_range(job->g->cscRow, job->g->cscColumn, first, last, job->local_c3[worker]);
+}
+
+static void body_lower(void *arg, int worker, uint32_t first, uint32_t last) {
+  count_job *job = arg;
+  lowertri_count_range(job->g->cscRow, job->g->cscColumn, first, last, job->marker[worker], job->local_c3[worker]);
+}
+
+static void body_columns(void *arg, int worker, uint32_t first, uint32_t last) {
+  count_job *job = arg;
+  spgemm_masked_range(job->engine, job->g->cscRow, job->g->cscColumn, first, last, job->c_values, job->ws[worker]);
+}
+
+static void body_tiles(void *arg, int worker, uint32_t first, uint32_t last) {
+  count_job *job = arg;
+  (void)worker;
+  tiling_dot_tiles(job->schedule, job->g->cscRow, job->g->cscColumn, first, last, job->c_values);
+}
+
+static void body_tasks(void *arg, int worker, uint32_t first, uint32_t last) {
+  count_job *job = arg;
+  (void)worker;
+  tasks_dot(job->plan, job->g->cscRow, job->g->cscColumn, first, last, job->c_values);
+}
+
+static void body_bitmap(void *arg, int worker, uint32_t first, uint32_t last) {
+  count_job *job = arg;
+  (void)worker;
+  bitmatrix_dot(job->bits, job->g->cscRow, job->g->cscColumn, first, last, job->c_values);
+}
+
+static void body_hubs(void *arg, int worker, uint32_t first, uint32_t last) {
+  count_job *job = arg;
+  (void)worker;
+  hubs_dot(job->hubs, job->g->cscRow, job->g->cscColumn, first, last, job->c_values);
+}
+
+static void body_packed(void *arg, int worker, uint32_t first, uint32_t last) {
+  count_job *job = arg;
+  packed_dot(job->g->packed, job->g->cscColumn, first, last, job->rows[worker], job->c_values);
+}
+
+static void body_edges(void *arg, int worker, uint32_t first, uint32_t last) {
+  count_job *job = arg;
+  uint32_t nnz = job->g->cscColumn[job->g->n];
+  uint32_t from = first * SPGEMM_EDGE_BLOCK;
+  uint32_t to = (uint64_t)last * SPGEMM_EDGE_BLOCK < nnz ? last * SPGEMM_EDGE_BLOCK : nnz;
+  (void)worker;
+  spgemm_dot_edges(job->g->cscRow, job->g->cscColumn, job->g->n, from, to, job->c_values);
+}
+
+#ifndef TRIANGLE_WITH_CILK
+/* Built without the Cilk compiler, the backend reports itself unavailable */
+int triangle_workers_cilk(int requested) {
+  (void)requested;
+  return -1;
+}
+
+void triangle_parallel_cilk(uint32_t items, uint32_t grain, int workers, int layout, triangle_body body, void *job) {
+  (void)grain;
+  (void)workers;
+  (void)layout;
+  body(job, 0, 0, items);
+}
+#endif
+
+/* Wraps the engine body when profiling, every worker adds up its own time */
+static void timed_body(void *arg, int worker, uint32_t first, uint32_t last) {
+  count_job *job = arg;
+  perfctr_sample before, after;
+  work_take(NULL);
+  if (job->prof->counters) perfctr_read(&before);
+  double start = profile_now();
+  job->body(job, worker, first, last);
+  double end = profile_now();
+  if (job->prof->counters) perfctr_read(&after);
+  if (job->prof->trace)
+    trace_record(&job->prof->trace->ring[worker], start, end, first, last, triangle_engine_name(job->engine));
+  uint64_t bytes = job->columns ? affinity_column_bytes(job->g->cscRow, job->g->cscColumn, first, last) : 0;
+  profile_worker(job->prof, worker, end - start, last - first, affinity_cpu(), bytes, &after, &before);
+}
+
+static void run(triangle_options const * opt, int workers, uint32_t items, triangle_body body, count_job *job) {
+  /* Chunks per worker: asked for, else what the engine choice wants, else the default */
+  uint32_t chunks = opt->chunks ? opt->chunks : job->g->chunks ? job->g->chunks : TRIANGLE_CHUNKS_PER_WORKER;
+  uint32_t grain = items / ((uint32_t)workers * chunks);
+  if (grain == 0) grain = 1;
+
+  if (job->prof) {
+    job->body = body;
+    body = timed_body;
+  }
+  switch (opt->backend) {
+    case TRIANGLE_OPENMP:   triangle_parallel_openmp(items, grain, workers, opt->layout, body, job);   break;
+    case TRIANGLE_CILK:     triangle_parallel_cilk(items, grain, workers, opt->layout, body, job);     break;
+    case TRIANGLE_PTHREADS: triangle_parallel_pthreads(items, grain, workers, opt->layout, body, job); break;
+    default:                body(job, 0, 0, items);                                                     break;
+  }
+}
+
+/**
+ *  \brief Count the triangles of g with the engine and backend of opt
+ *
+ *  Returns 0 on success and 1 if the backend is not available in this
+ *  build. r->c3 is allocated here, release it with triangle_result_free.
+ */
+int triangle_count(
+  triangle_graph   const * g,
+  triangle_options const * opt,
+  triangle_result        * r
+) {
+  profile *prof = opt->profile;
+  uint32_t n = g->n;
+  int workers = triangle_workers(opt);
+  double start;
+  count_job job;
+
+  profile_begin(prof);
+  memset(r, 0, sizeof(triangle_result));
+  memset(&job, 0, sizeof(count_job));
+  if (workers < 1) return 1;
+
+  job.g = g;
+  job.prof = prof;
+  job.engine = g->engine;
+  if (job.engine == SPGEMM_AUTO || job.engine == TRIANGLE_AUTO) job.engine = spgemm_choose_engine(n, g->nnz, workers);
+  r->engine = job.engine;
+  r->workers = workers;
+  job.columns = g->cscRow != NULL && job.engine != SPGEMM_TILED && job.engine != SPGEMM_TASKS &&
+                job.engine != SPGEMM_EDGES;
+  r->c3 = calloc(n + 1, sizeof(int));
+
+  // ----- everything that is not counting: workspaces, tiles, task plan
+  profile_workers(prof, workers);
+  if (prof) prof->intersections = g->nnz;
+  start = profile_now();
+  int per_vertex = job.engine == TRIANGLE_V3 || job.engine == SPGEMM_LOWER;
+  if (per_vertex) {
+    job.local_c3 = malloc(workers * sizeof(int *));
+    job.found = calloc(workers, sizeof(uint64_t));
+    for (int w = 0; w < workers; w++) job.local_c3[w] = calloc(n + 1, sizeof(int));
+    if (job.engine == SPGEMM_LOWER) {
+      job.marker = malloc(workers * sizeof(uint32_t *));
+      for (int w = 0; w < workers; w++) job.marker[w] = lowertri_marker_create(n);
+    }
+  }
+  else {
+    job.c_values = malloc((g->nnz + 1) * sizeof(uint32_t));
+    if (job.engine == SPGEMM_TILED) job.schedule = tiling_build(g->cscRow, g->cscColumn, n, opt->tile_size, opt->curve);
+    else if (job.engine == SPGEMM_TASKS) job.plan = tasks_build(g->cscRow, g->cscColumn, n, workers);
+    else if (job.engine == TRIANGLE_BITMAP) job.bits = bitmatrix_build(g->cscRow, g->cscColumn, n, BITMATRIX_BUDGET);
+    else if (job.engine == TRIANGLE_PACKED) {
+      uint32_t max_degree = 0;
+      for (uint32_t j = 0; j < n; j++)
+        if (g->cscColumn[j+1] - g->cscColumn[j] > max_degree) max_degree = g->cscColumn[j+1] - g->cscColumn[j];
+      job.rows = malloc(workers * sizeof(uint32_t *));
+      for (int w = 0; w < workers; w++) job.rows[w] = malloc((max_degree + 1) * sizeof(uint32_t));
+    }
+    else if (job.engine == TRIANGLE_HUBS) {
+      job.hubs = hubs_build(g->cscRow, g->cscColumn, n, HUBS_BUDGET);
+      r->hubs = job.hubs->hubs;
+      r->hub_share = job.hubs->share;
+    }
+    else {
+      job.ws = malloc(workers * sizeof(spgemm_workspace *));
+      for (int w = 0; w < workers; w++) job.ws[w] = spgemm_workspace_create(job.engine, g->cscColumn, n);
+    }
+  }
+  r->prepare_time = profile_now() - start;
+  profile_end(prof, PROFILE_PREPARE);
+
+  /* We measure time from this point */
+  start = profile_now();
+
+  switch (job.engine) {
+    case TRIANGLE_V3:  run(opt, workers, n, body_v3, &job);                     break;
+    case SPGEMM_LOWER: run(opt, workers, n, body_lower, &job);                  break;
+    case SPGEMM_TILED: run(opt, workers, job.schedule->tiles, body_tiles, &job); break;
+    case SPGEMM_TASKS: run(opt, workers, job.plan->tasks, body_tasks, &job);    break;
+    case TRIANGLE_BITMAP: run(opt, workers, n, body_bitmap, &job);              break;
+    case TRIANGLE_HUBS: run(opt, workers, n, body_hubs, &job);                  break;
+    case TRIANGLE_PACKED: run(opt, workers, n, body_packed, &job);              break;
+    case SPGEMM_EDGES:
+      run(opt, workers, (g->nnz + SPGEMM_EDGE_BLOCK - 1) / SPGEMM_EDGE_BLOCK, body_edges, &job);
+      break;
+    default:           run(opt, workers, n, body_columns, &job);                break;
+  }
+  profile_end(prof, PROFILE_KERNEL);
+
+  uint64_t sum = 0;
+  if (per_vertex) {
+    /* Every triangle was found once, sum the per worker copies of c3 */
+    for (int w = 0; w < workers; w++) {
+      for (uint32_t v = 0; v < n; v++) r->c3[v] += job.local_c3[w][v];
+      sum += job.found[w];
+    }
+    profile_end(prof, PROFILE_SPMV);
+    if (job.engine == SPGEMM_LOWER) {
+      sum = 0;
+      for (uint32_t v = 0; v < n; v++) sum += r->c3[v];
+      sum /= 3;
+    }
+  }
+  else {
+    /* Multiplication of C with a vector of ones, every triangle is seen twice per vertex */
+    for (uint32_t i = 0; i < n; i++) {
+      uint32_t const *rows = g->packed ? job.rows[0] : g->cscRow + g->cscColumn[i];
+      if (g->packed) packed_decode(g->packed, g->cscColumn, i, job.rows[0]);
+      for (uint32_t p = g->cscColumn[i]; p < g->cscColumn[i+1]; p++)
+        r->c3[rows[p - g->cscColumn[i]]] += job.c_values[p];
+    }
+    profile_end(prof, PROFILE_SPMV);
+    for (uint32_t v = 0; v < n; v++) {
+      r->c3[v] /= 2;
+      sum += r->c3[v];
+    }
+    sum /= 3;
+  }
+  r->triangles = sum;
+
+  /* We stop measuring time at this point */
+  r->duration = profile_now() - start;
+
+  /* c3 back under the original vertex ids, peeled vertices close none */
+  if (g->kept) {
+    int *all = calloc((size_t)g->vertices + 1, sizeof(int));
+    #pragma omp parallel for
+    for (uint32_t v = 0; v < n; v++) all[g->kept[v]] = r->c3[v];
+    free(r->c3);
+    r->c3 = all;
+  }
+  if (g->perm) reorder_scatter_back(r->c3, g->perm, g->vertices);
+  profile_end(prof, PROFILE_C3);
+
+  if (job.local_c3) for (int w = 0; w < workers; w++) free(job.local_c3[w]);
+  if (job.marker)   for (int w = 0; w < workers; w++) free(job.marker[w]);
+  if (job.ws)       for (int w = 0; w < workers; w++) spgemm_workspace_free(job.ws[w]);
+  if (job.rows)     for (int w = 0; w < workers; w++) free(job.rows[w]);
+  free(job.local_c3);
+  free(job.found);
+  free(job.marker);
+  free(job.ws);
+  free(job.rows);
+  free(job.c_values);
+  tiling_free(job.schedule);
+  tasks_free(job.plan);
+  bitmatrix_free(job.bits);
+  hubs_free(job.hubs);
+
+  return 0;
+}
+
+void triangle_result_free(triangle_result *r) {
+  free(r->c3);
+  r->c3 = NULL;
+}
@@ -0,0 +1,135 @@
+#ifndef LIBTRIANGLE_H
+#define LIBTRIANGLE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "profile.h"
+#include "stats.h"
+#include "packed.h"
+#include "canon.h"
+#include "prune.h"
+
+/* Engines on top of the SPGEMM_* ones of spgemm.h */
+#define TRIANGLE_V3   16   /* triple loop on one triangle, the original V3 */
+#define TRIANGLE_AUTO 17   /* any engine, picked from the graph statistics */
+#define TRIANGLE_BITMAP 18 /* dot product on bitsets of dense blocks, see bitmatrix.c */
+#define TRIANGLE_HUBS   19 /* dot product probing bitmaps of the hubs, see hubs.c */
+#define TRIANGLE_PACKED 20 /* dot product on the compressed CSC, see packed.c */
+
+/* Backends */
+#define TRIANGLE_SEQ       0
+#define TRIANGLE_OPENMP    1
+#define TRIANGLE_CILK      2   /* only when built with the Cilk compiler */
+#define TRIANGLE_PTHREADS  3
+
+/* Items a worker takes at once, relative to items per worker */
+#define TRIANGLE_CHUNKS_PER_WORKER 16
+
+/* Cost model of TRIANGLE_AUTO */
+#define TRIANGLE_HUB_SKEW   64    /* max over mean degree from which hubs straggle */
+#define TRIANGLE_REASON     512   /* room for the explanation of the choice */
+
+typedef struct {
+  int       engine;      /*!< SPGEMM_*, TRIANGLE_V3 or TRIANGLE_AUTO */
+  int       backend;     /*!< TRIANGLE_SEQ ... TRIANGLE_PTHREADS */
+  int       workers;     /*!< Threads, ignored by TRIANGLE_SEQ */
+  int       reorder;     /*!< REORDER_* */
+  uint32_t  tile_size;   /*!< Tiled engine, 0 fits the LLC */
+  int       curve;       /*!< Tiled engine, TILING_* */
+  int       layout;      /*!< AFFINITY_* pinning of the workers */
+  int       placement;   /*!< AFFINITY_TOUCH or AFFINITY_INTERLEAVE of the CSC */
+  uint32_t  chunks;      /*!< Chunks per worker, 0 lets the engine choice decide */
+  int       prune;       /*!< Count on the 2-core, vertices of degree < 2 peeled off */
+  profile  *profile;     /*!< Phase timings go here when not NULL */
+} triangle_options;
+
+/* The file as read: one triangle of a symmetric matrix, 0-based */
+typedef struct {
+  uint32_t  n;           /*!< Number of rows/columns */
+  uint32_t  nz;          /*!< Entries in the file */
+  uint32_t *row;         /*!< Row indices (nz) */
+  uint32_t *col;         /*!< Column indices (nz) */
+  int       general;     /*!< Banner is general, both triangles may be stored */
+  int       canonical;   /*!< Loader guarantees canonical order, see canon.h, so canon_coo is skipped */
+} triangle_coo;
+
+typedef struct {
+  uint32_t  n;           /*!< Number of rows/columns, of the 2-core when pruned */
+  uint32_t  vertices;    /*!< Vertices of the input, the length of c3 */
+  uint32_t  nnz;         /*!< Stored nonzeros */
+  uint32_t *cscRow;      /*!< Row indices, sorted and distinct per column, NULL once packed */
+  uint32_t *cscColumn;   /*!< Column start indices (n+1) */
+  int       engine;      /*!< Engine the layout was built for */
+  uint32_t *perm;        /*!< perm[new] = old when reordered, else NULL */
+  double    reorder_time;
+  uint32_t *kept;        /*!< kept[new] = id before pruning when pruned, else NULL */
+  prune_stats prune;     /*!< Reduction of the pruning pass */
+  packed_csc *packed;    /*!< Rows of TRIANGLE_PACKED, replaces cscRow */
+  uint32_t  chunks;      /*!< Chunks per worker the engine choice asks for, 0 for the default */
+  int       placement;   /*!< Placement the CSC got, interleave falls back to first touch */
+  canon_stats canon;     /*!< What canonicalization fixed in the input */
+  graph_stats stats;     /*!< Filled when the engine was TRIANGLE_AUTO */
+  char      reason[TRIANGLE_REASON]; /*!< Why TRIANGLE_AUTO chose the engine, else empty */
+} triangle_graph;
+
+typedef struct {
+  uint64_t  triangles;   /*!< Triangles of the graph */
+  int      *c3;          /*!< Triangles per vertex, original ids (vertices) */
+  int       engine;      /*!< Engine that ran, auto resolved */
+  int       workers;     /*!< Workers that ran */
+  double    prepare_time;/*!< Tiles, task plan, workspaces */
+  double    duration;    /*!< Kernel and reduction */
+  uint32_t  hubs;        /*!< Hubs engine: columns with a bitmap */
+  double    hub_share;   /*!< Hubs engine: nonzeros answered by a bitmap */
+} triangle_result;
+
+void triangle_default_options(triangle_options *opt);
+
+int triangle_parse_engine(const char *name);
+
+const char *triangle_engine_name(int engine);
+
+int triangle_parse_backend(const char *name);
+
+const char *triangle_backend_name(int backend);
+
+int triangle_load(const char * const source, triangle_options const * opt, triangle_coo *coo);
+
+int triangle_load_mtx(const char * const filename, triangle_coo *coo, profile *prof);
+
+int triangle_load_csc(const char * const filename, triangle_coo *coo, profile *prof);
+
+void triangle_coo_free(triangle_coo *coo);
+
+int triangle_workers(triangle_options const * opt);
+
+int triangle_build(
+  triangle_coo           * coo,    /*!< Relabelled and canonicalized in place */
+  triangle_options const * opt,
+  triangle_graph         * g
+);
+
+void triangle_graph_free(triangle_graph *g);
+
+int triangle_count(
+  triangle_graph   const * g,
+  triangle_options const * opt,
+  triangle_result        * r
+);
+
+void triangle_result_free(triangle_result *r);
+
+/* Backends run body over [0, items) in chunks of grain items, worker is 0..workers-1 */
+typedef void (*triangle_body)(void *job, int worker, uint32_t first, uint32_t last);
+
+int triangle_workers_openmp(int requested);
+void triangle_parallel_openmp(uint32_t items, uint32_t grain, int workers, int layout, triangle_body body, void *job);
+
+int triangle_workers_pthreads(int requested);
+void triangle_parallel_pthreads(uint32_t items, uint32_t grain, int workers, int layout, triangle_body body, void *job);
+
+int triangle_workers_cilk(int requested);
+void triangle_parallel_cilk(uint32_t items, uint32_t grain, int workers, int layout, triangle_body body, void *job);
+
+#endif
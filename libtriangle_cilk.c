@@ -0,0 +1,43 @@
+/**
+ *   \file libtriangle_cilk.c
+ *   \brief Cilk backend of libtriangle, built only with the Cilk compiler
+ *
+ *   cilk_for splits the chunks by work stealing, the worker number picks
+ *   the workspace. Pinning is left to the Cilk runtime.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <cilk/cilk.h>
+#include <cilk/cilk_api.h>
+#include "libtriangle.h"
+
+/*
+ *  The runtime keeps the worker count it started with and refuses
+ *  nworkers from then on. Asking for another count is an error, -1,
+ *  rather than a run on the old count under the new label.
+ */
+int triangle_workers_cilk(int requested) {
+  if (requested > 0) {
+    char workers[16];
+    snprintf(workers, sizeof(workers), "%d", requested);
+    if (__cilkrts_set_param("nworkers", workers) != 0 && __cilkrts_get_nworkers() != requested) {
+      fprintf(stderr, "Cilk runs %d workers and cannot switch to %d\n", __cilkrts_get_nworkers(), requested);
+      return -1;
+    }
+  }
+  return __cilkrts_get_nworkers();
+}
+
+void triangle_parallel_cilk(uint32_t items, uint32_t grain, int workers, int layout, triangle_body body, void *job) {
+  uint32_t chunks = (items + grain - 1) / grain;
+  (void)workers;
+  (void)layout;
+
+  cilk_for (uint32_t c = 0; c < chunks; c++) {
+    uint32_t first = c * grain;
+    uint32_t last = first + grain < items ? first + grain : items;
+    body(job, __cilkrts_get_worker_number(), first, last);
+  }
+}
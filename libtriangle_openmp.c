@@ -0,0 +1,35 @@
+/**
+ *   \file libtriangle_openmp.c
+ *   \brief OpenMP backend of libtriangle
+ *
+ *   The items are handed out in chunks from a dynamic schedule, each
+ *   thread works in the workspace of its thread number.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <omp.h>
+#include "affinity.h"
+#include "libtriangle.h"
+
+int triangle_workers_openmp(int requested) {
+  return requested > 0 ? requested : omp_get_max_threads();
+}
+
+void triangle_parallel_openmp(uint32_t items, uint32_t grain, int workers, int layout, triangle_body body, void *job) {
+  uint32_t chunks = (items + grain - 1) / grain;
+
+  #pragma omp parallel num_threads(workers)
+  {
+    int id = omp_get_thread_num();
+    if (layout != AFFINITY_NONE) affinity_pin(layout, id);
+
+    #pragma omp for schedule(dynamic, 1)
+    for (uint32_t c = 0; c < chunks; c++) {
+      uint32_t first = c * grain;
+      uint32_t last = first + grain < items ? first + grain : items;
+      body(job, id, first, last);
+    }
+  }
+}
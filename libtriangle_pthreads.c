@@ -0,0 +1,65 @@
+/**
+ *   \file libtriangle_pthreads.c
+ *   \brief POSIX threads backend of libtriangle
+ *
+ *   The threads take chunks of items from a shared counter until it runs
+ *   past the end, so a thread that drew cheap items simply takes more.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "affinity.h"
+#include "libtriangle.h"
+
+typedef struct {
+  int           id;
+  int           layout;
+  uint32_t      items;
+  uint32_t      grain;
+  uint32_t     *next;       /* shared, first item not yet handed out */
+  triangle_body body;
+  void         *job;
+} worker_args;
+
+static void *worker(void *arg) {
+  worker_args *w = arg;
+
+  if (w->layout != AFFINITY_NONE) affinity_pin(w->layout, w->id);
+  for (;;) {
+    uint32_t first = __atomic_fetch_add(w->next, w->grain, __ATOMIC_RELAXED);
+    if (first >= w->items) break;
+    uint32_t last = w->items - first > w->grain ? first + w->grain : w->items;
+    w->body(w->job, w->id, first, last);
+  }
+  return NULL;
+}
+
+int triangle_workers_pthreads(int requested) {
+  if (requested > 0) return requested;
+  long online = sysconf(_SC_NPROCESSORS_ONLN);
+  return online > 0 ? (int)online : 1;
+}
+
+void triangle_parallel_pthreads(uint32_t items, uint32_t grain, int workers, int layout, triangle_body body, void *job) {
+  pthread_t   *threads = malloc(workers * sizeof(pthread_t));
+  worker_args *args = malloc(workers * sizeof(worker_args));
+  uint32_t next = 0;
+
+  for (int t = 0; t < workers; t++) {
+    args[t].id = t;
+    args[t].layout = layout;
+    args[t].items = items;
+    args[t].grain = grain;
+    args[t].next = &next;
+    args[t].body = body;
+    args[t].job = job;
+    pthread_create(&threads[t], NULL, worker, &args[t]);
+  }
+  for (int t = 0; t < workers; t++) pthread_join(threads[t], NULL);
+
+  free(threads);
+  free(args);
+}
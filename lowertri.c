@@ -0,0 +1,114 @@
+/**
+ *   \file lowertri.c
+ *   \brief Triangle counting on the strictly lower half, C = L.*(L*L)
+ *
+ *   Working on L alone halves the matrix and finds every triangle exactly
+ *   once, at its smallest vertex j, through the wedge j < k < i. The
+ *   full-A masked product does the same work six times over.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "lowertri.h"
+#include "work.h"
+
+/**
+ *  \brief Build the strictly lower triangular CSC from a one-triangle COO
+ *
+ *  Each entry is oriented so that its row is the larger index, so the
+ *  input may hold the upper or the lower triangle. Diagonal entries are
+ *  dropped. Returns the number of nonzeros of L.
+ */
+uint32_t lowertri_build(
+  uint32_t       * const lRow,
+  uint32_t       * const lColumn,
+  uint32_t const * const row_coo,
+  uint32_t const * const col_coo,
+  uint32_t const         nz,
+  uint32_t const         n
+) {
+
+  for (uint32_t l = 0; l < n+1; l++) lColumn[l] = 0;
+
+  // ----- column sizes, the column is always the smaller index
+  for (uint32_t l = 0; l < nz; l++) {
+    uint32_t a = row_coo[l], b = col_coo[l];
+    if (a != b) lColumn[(a < b ? a : b) + 1]++;
+  }
+
+  // ----- cumulative sum, lColumn[j] now holds the start of column j
+  for (uint32_t i = 0; i < n; i++)
+    lColumn[i+1] += lColumn[i];
+
+  // ----- scatter, using lColumn[j] as the fill pointer of column j
+  for (uint32_t l = 0; l < nz; l++) {
+    uint32_t a = row_coo[l], b = col_coo[l];
+    if (a == b) continue;
+    uint32_t lo = a < b ? a : b;
+    uint32_t hi = a < b ? b : a;
+    lRow[lColumn[lo]++] = hi;
+  }
+
+  // ----- lColumn[j] is now the end of column j, shift it back to the start
+  for (uint32_t i = n; i > 0; i--)
+    lColumn[i] = lColumn[i-1];
+  lColumn[0] = 0;
+
+  return lColumn[n];
+}
+
+uint32_t *lowertri_marker_create(uint32_t const n) {
+  uint32_t *marker = malloc(n * sizeof(uint32_t));
+  for (uint32_t i = 0; i < n; i++) marker[i] = UINT32_MAX;
+  return marker;
+}
+
+/**
+ *  \brief Count the triangles whose smallest vertex lies in [start, end)
+ *
+ *  Column j of L is scattered into the marker (tagged with j, so it never
+ *  needs clearing), then L(:,k) is expanded for every k in L(:,j). Each
+ *  hit closes the triangle (j, k, i) and is credited to all three
+ *  vertices in the worker's own c3, which the caller sums at the end.
+ */
+uint32_t lowertri_count_range(
+  uint32_t const * const lRow,
+  uint32_t const * const lColumn,
+  uint32_t const         start,
+  uint32_t const         end,
+  uint32_t       * const marker,
+  int            * const c3
+) {
+  uint32_t triangles = 0;
+
+  for (uint32_t j = start; j < end; j++) {
+    uint32_t column_hits = 0;
+
+    for (uint32_t p = lColumn[j]; p < lColumn[j+1]; p++)
+      marker[lRow[p]] = j;
+
+    for (uint32_t p = lColumn[j]; p < lColumn[j+1]; p++) {
+      uint32_t k = lRow[p];
+      uint32_t hits = 0;
+      for (uint32_t q = lColumn[k]; q < lColumn[k+1]; q++) {
+        uint32_t i = lRow[q];
+        if (marker[i] == j) {
+          hits++;
+          c3[i]++;
+        }
+      }
+      c3[k] += hits;
+      column_hits += hits;
+      WORK_ADD(wedges, lColumn[k+1] - lColumn[k]);
+      WORK_ADD(compared, lColumn[k+1] - lColumn[k]);
+      WORK_ADD(hits, hits);
+      WORK_SIZE(lColumn[k+1] - lColumn[k]);
+    }
+
+    c3[j] += column_hits;
+    triangles += column_hits;
+  }
+
+  return triangles;
+}
@@ -0,0 +1,28 @@
+#ifndef LOWERTRI_H
+#define LOWERTRI_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+uint32_t lowertri_build(
+  uint32_t       * const lRow,      /*!< CSC row indices of L (size nz) */
+  uint32_t       * const lColumn,   /*!< CSC column start indices of L (size n+1) */
+  uint32_t const * const row_coo,   /*!< COO row indices, 0-based */
+  uint32_t const * const col_coo,   /*!< COO column indices, 0-based */
+  uint32_t const         nz,        /*!< Number of COO entries (one triangle) */
+  uint32_t const         n          /*!< Number of rows/columns */
+);
+
+uint32_t *lowertri_marker_create(uint32_t const n);
+
+uint32_t lowertri_count_range(
+  uint32_t const * const lRow,      /*!< CSC row indices of L */
+  uint32_t const * const lColumn,   /*!< CSC column start indices of L */
+  uint32_t const         start,     /*!< First column to count */
+  uint32_t const         end,       /*!< One past the last column */
+  uint32_t       * const marker,    /*!< Per worker marker from lowertri_marker_create */
+  int            * const c3         /*!< Per worker triangles per vertex, accumulated */
+);
+
+#endif
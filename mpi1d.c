@@ -0,0 +1,292 @@
+/**
+ *   \file mpi1d.c
+ *   \brief 1D vertex partitioned triangle counting on the strictly lower half
+ *
+ *   Every rank owns a block of columns of L. A triangle j < k < i is found
+ *   at the owner of column j by intersecting column j with column k. When k
+ *   belongs to another rank its column is fetched in batched all-to-all
+ *   rounds, so no rank ever holds more than MPI1D_BATCH remote columns per
+ *   owner at once. The per-vertex counts are accumulated in a full length
+ *   vector and reduce-scattered back to the owners at the end.
+ *
+ *   The ids and lengths of all requested columns are exchanged once up
+ *   front, after that every round is a single non-blocking all-to-all of
+ *   rows whose sizes both sides already know. Round r+1 is in flight while
+ *   the OpenMP threads intersect round r, and round 0 while they count the
+ *   own columns.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <mpi.h>
+#include "dist.h"
+#include "mpi1d.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+typedef struct {
+  uint32_t   *send;      /*!< Rows of the asked columns, by requester */
+  uint32_t   *recv;      /*!< Rows of the needed columns, by owner */
+  int        *scount, *sdispl;
+  int        *rcount, *rdispl;
+  MPI_Request req;
+} round_buffer;
+
+static int compare_wedge(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static int batch_end(int const from, int const end) {
+  return from + MPI1D_BATCH < end ? from + MPI1D_BATCH : end;
+}
+
+/* Pack the rows asked for in the given round and post the exchange */
+static void post_round(
+  dist_graph const * const g,
+  MPI_Comm const           comm,
+  int const                round,
+  uint32_t const * const   asked,       /*!< Asked ids, by requester */
+  int const      * const   asked_start, /*!< size+1 */
+  uint32_t const * const   need_off,    /*!< Prefix sums of the needed lengths */
+  int const      * const   need_start,  /*!< size+1 */
+  round_buffer   * const   b,
+  uint64_t       * const   bytes
+) {
+  int P = g->size;
+
+  b->sdispl[0] = b->rdispl[0] = 0;
+  for (int q = 0; q < P; q++) {
+    int from = asked_start[q] + round * MPI1D_BATCH, to = batch_end(from, asked_start[q+1]);
+    b->scount[q] = 0;
+    for (int a = from; a < to; a++) {
+      uint32_t c = asked[a] - g->first;
+      b->scount[q] += g->col[c+1] - g->col[c];
+    }
+    b->sdispl[q+1] = b->sdispl[q] + b->scount[q];
+
+    from = need_start[q] + round * MPI1D_BATCH;
+    to = batch_end(from, need_start[q+1]);
+    b->rcount[q] = from < to ? need_off[to] - need_off[from] : 0;
+    b->rdispl[q+1] = b->rdispl[q] + b->rcount[q];
+  }
+
+  b->send = realloc(b->send, (b->sdispl[P] + 1) * sizeof(uint32_t));
+  b->recv = realloc(b->recv, (b->rdispl[P] + 1) * sizeof(uint32_t));
+  for (int q = 0, fill = 0; q < P; q++) {
+    int from = asked_start[q] + round * MPI1D_BATCH, to = batch_end(from, asked_start[q+1]);
+    for (int a = from; a < to; a++) {
+      uint32_t c = asked[a] - g->first;
+      memcpy(b->send + fill, g->row + g->col[c], (g->col[c+1] - g->col[c]) * sizeof(uint32_t));
+      fill += g->col[c+1] - g->col[c];
+    }
+  }
+  MPI_Ialltoallv(b->send, b->scount, b->sdispl, MPI_UINT32_T,
+                 b->recv, b->rcount, b->rdispl, MPI_UINT32_T, comm, &b->req);
+  *bytes += (uint64_t)b->sdispl[P] * sizeof(uint32_t);
+}
+
+uint64_t mpi1d_count(
+  dist_graph const * const g,
+  MPI_Comm const           comm,
+  int              * const c3,
+  int const                workers,
+  dist_stats       * const st
+) {
+  int P = g->size;
+  uint32_t columns = g->last - g->first;
+  uint64_t triangles = 0;
+  int **local_c3 = malloc(workers * sizeof(int *));
+  double start = MPI_Wtime();
+
+  for (int w = 0; w < workers; w++) local_c3[w] = calloc(g->n, sizeof(int));
+#ifdef _OPENMP
+  omp_set_dynamic(0);
+  omp_set_num_threads(workers);
+#endif
+
+  // ----- remote pairs (j, k) become wedges keyed by k
+  uint64_t wedges = 0;
+  for (uint32_t l = 0; l < g->nnz; l++)
+    if (g->row[l] >= g->last) wedges++;
+  uint64_t *wedge = malloc((wedges + 1) * sizeof(uint64_t));
+  wedges = 0;
+  for (uint32_t c = 0; c < columns; c++)
+    for (uint32_t l = g->col[c]; l < g->col[c+1]; l++)
+      if (g->row[l] >= g->last) wedge[wedges++] = ((uint64_t)g->row[l] << 32) | (g->first + c);
+  qsort(wedge, wedges, sizeof(uint64_t), compare_wedge);
+
+  // ----- distinct remote columns, grouped by owner (ids ascending)
+  uint32_t *need = malloc((wedges + 1) * sizeof(uint32_t));
+  uint64_t *need_wedge = malloc((wedges + 1) * sizeof(uint64_t));
+  uint32_t needed = 0;
+  for (uint64_t w = 0; w < wedges; w++) {
+    uint32_t k = wedge[w] >> 32;
+    if (needed == 0 || need[needed-1] != k) {
+      need_wedge[needed] = w;
+      need[needed++] = k;
+    }
+  }
+  need_wedge[needed] = wedges;
+  int *need_start = calloc(P + 1, sizeof(int));
+  for (uint32_t v = 0; v < needed; v++) need_start[dist_owner(g, need[v]) + 1]++;
+  for (int q = 0; q < P; q++) need_start[q+1] += need_start[q];
+  st->time[DIST_COUNT] += MPI_Wtime() - start;
+
+  // ----- ids and lengths of all rounds at once, they are small next to the rows
+  start = MPI_Wtime();
+  int *need_count = malloc(P * sizeof(int)), *asked_count = malloc(P * sizeof(int));
+  int *asked_start = malloc((P + 1) * sizeof(int));
+  for (int q = 0; q < P; q++) need_count[q] = need_start[q+1] - need_start[q];
+  MPI_Alltoall(need_count, 1, MPI_INT, asked_count, 1, MPI_INT, comm);
+  asked_start[0] = 0;
+  for (int q = 0; q < P; q++) asked_start[q+1] = asked_start[q] + asked_count[q];
+
+  uint32_t *asked = malloc((asked_start[P] + 1) * sizeof(uint32_t));
+  MPI_Alltoallv(need, need_count, need_start, MPI_UINT32_T,
+                asked, asked_count, asked_start, MPI_UINT32_T, comm);
+  uint32_t *asked_length = malloc((asked_start[P] + 1) * sizeof(uint32_t));
+  for (int a = 0; a < asked_start[P]; a++)
+    asked_length[a] = g->col[asked[a] - g->first + 1] - g->col[asked[a] - g->first];
+  uint32_t *need_off = malloc((needed + 1) * sizeof(uint32_t));
+  MPI_Alltoallv(asked_length, asked_count, asked_start, MPI_UINT32_T,
+                need_off, need_count, need_start, MPI_UINT32_T, comm);
+  for (uint32_t v = 0, sum = 0; v <= needed; v++) {
+    uint32_t length = v < needed ? need_off[v] : 0;
+    need_off[v] = sum;
+    sum += length;
+  }
+  st->bytes[DIST_EXCHANGE] += ((uint64_t)needed + 2 * asked_start[P] + P) * sizeof(uint32_t);
+
+  int rounds = 0;
+  for (int q = 0; q < P; q++) {
+    int r = (need_count[q] + MPI1D_BATCH - 1) / MPI1D_BATCH;
+    if (r > rounds) rounds = r;
+  }
+  MPI_Allreduce(MPI_IN_PLACE, &rounds, 1, MPI_INT, MPI_MAX, comm);
+
+  round_buffer buffer[2];
+  for (int b = 0; b < 2; b++) {
+    buffer[b].send = buffer[b].recv = NULL;
+    buffer[b].scount = malloc(P * sizeof(int));
+    buffer[b].rcount = malloc(P * sizeof(int));
+    buffer[b].sdispl = malloc((P + 1) * sizeof(int));
+    buffer[b].rdispl = malloc((P + 1) * sizeof(int));
+  }
+  if (rounds > 0)
+    post_round(g, comm, 0, asked, asked_start, need_off, need_start, &buffer[0], &st->bytes[DIST_EXCHANGE]);
+  st->time[DIST_EXCHANGE] += MPI_Wtime() - start;
+
+  // ----- own columns while round 0 is on the wire
+  start = MPI_Wtime();
+  #pragma omp parallel for schedule(dynamic, 64) reduction(+:triangles)
+  for (uint32_t c = 0; c < columns; c++) {
+    int w = 0;
+#ifdef _OPENMP
+    w = omp_get_thread_num();
+#endif
+    uint32_t j = g->first + c;
+    for (uint32_t l = g->col[c]; l < g->col[c+1]; l++) {
+      uint32_t k = g->row[l];
+      if (k >= g->last) continue;
+      uint32_t found = dist_intersect(g->row + l + 1, g->col[c+1] - l - 1,
+                                      g->row + g->col[k - g->first],
+                                      g->col[k - g->first + 1] - g->col[k - g->first], local_c3[w]);
+      local_c3[w][j] += found;
+      local_c3[w][k] += found;
+      triangles += found;
+    }
+  }
+  st->time[DIST_COUNT] += MPI_Wtime() - start;
+
+  uint32_t *batch = malloc((P * MPI1D_BATCH + 1) * sizeof(uint32_t));
+  uint32_t *batch_off = malloc((P * MPI1D_BATCH + 1) * sizeof(uint32_t));
+
+  for (int round = 0; round < rounds; round++) {
+    round_buffer *b = &buffer[round & 1];
+
+    start = MPI_Wtime();
+    MPI_Wait(&b->req, MPI_STATUS_IGNORE);
+    if (round + 1 < rounds)
+      post_round(g, comm, round + 1, asked, asked_start, need_off, need_start,
+                 &buffer[(round + 1) & 1], &st->bytes[DIST_EXCHANGE]);
+    st->time[DIST_EXCHANGE] += MPI_Wtime() - start;
+    start = MPI_Wtime();
+
+    // ----- needed columns of this round and where their rows landed
+    int batched = 0;
+    for (int q = 0; q < P; q++) {
+      int from = need_start[q] + round * MPI1D_BATCH, to = batch_end(from, need_start[q+1]);
+      for (int v = from; v < to; v++) {
+        batch[batched] = v;
+        batch_off[batched++] = b->rdispl[q] + need_off[v] - need_off[from];
+      }
+    }
+
+    #pragma omp parallel for schedule(dynamic, 16) reduction(+:triangles)
+    for (int a = 0; a < batched; a++) {
+      int w = 0;
+#ifdef _OPENMP
+      w = omp_get_thread_num();
+#endif
+      uint32_t v = batch[a], k = need[v];
+      uint32_t const *rows = b->recv + batch_off[a];
+      uint32_t length = need_off[v+1] - need_off[v];
+      for (uint64_t x = need_wedge[v]; x < need_wedge[v+1]; x++) {
+        uint32_t j = (uint32_t)wedge[x];
+        uint32_t c = j - g->first;
+        /* rows of column j below k, k itself is found by binary search */
+        uint32_t lo = g->col[c], hi = g->col[c+1];
+        while (lo < hi) {
+          uint32_t mid = lo + (hi - lo) / 2;
+          if (g->row[mid] <= k) lo = mid + 1;
+          else                  hi = mid;
+        }
+        uint32_t found = dist_intersect(g->row + lo, g->col[c+1] - lo, rows, length, local_c3[w]);
+        local_c3[w][j] += found;
+        local_c3[w][k] += found;
+        triangles += found;
+      }
+    }
+    st->time[DIST_COUNT] += MPI_Wtime() - start;
+  }
+
+  // ----- per-vertex counts back to the owners, global sum to everyone
+  start = MPI_Wtime();
+  #pragma omp parallel for
+  for (uint32_t v = 0; v < g->n; v++)
+    for (int w = 1; w < workers; w++)
+      local_c3[0][v] += local_c3[w][v];
+  for (int q = 0; q < P; q++) need_count[q] = g->bound[q+1] - g->bound[q];
+  MPI_Reduce_scatter(local_c3[0], c3, need_count, MPI_INT, MPI_SUM, comm);
+  MPI_Allreduce(MPI_IN_PLACE, &triangles, 1, MPI_UINT64_T, MPI_SUM, comm);
+  st->bytes[DIST_REDUCE] += ((uint64_t)g->n - columns) * sizeof(int) + sizeof(uint64_t);
+  st->time[DIST_REDUCE] += MPI_Wtime() - start;
+
+  for (int w = 0; w < workers; w++) free(local_c3[w]);
+  free(local_c3);
+  free(wedge);
+  free(need);
+  free(need_wedge);
+  free(need_start);
+  free(need_count);
+  free(need_off);
+  free(asked_count);
+  free(asked_start);
+  free(asked);
+  free(asked_length);
+  free(batch);
+  free(batch_off);
+  for (int b = 0; b < 2; b++) {
+    free(buffer[b].send);
+    free(buffer[b].recv);
+    free(buffer[b].scount); free(buffer[b].sdispl);
+    free(buffer[b].rcount); free(buffer[b].rdispl);
+  }
+
+  return triangles;
+}
@@ -0,0 +1,21 @@
+#ifndef MPI1D_H
+#define MPI1D_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <mpi.h>
+#include "dist.h"
+
+/* Remote columns requested from every owner per exchange round */
+#define MPI1D_BATCH 4096
+
+uint64_t mpi1d_count(
+  dist_graph const * const g,
+  MPI_Comm const           comm,
+  int              * const c3,      /*!< Triangles of the own vertices (last-first) */
+  int const                workers, /*!< OpenMP threads of this rank */
+  dist_stats       * const st
+);
+
+#endif
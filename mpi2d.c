@@ -0,0 +1,289 @@
+/**
+ *   \file mpi2d.c
+ *   \brief 2D block distributed masked SpGEMM C = A.*(A*A), SUMMA style
+ *
+ *   The symmetric A is split in q x q blocks of about n/q vertices. At stage
+ *   s rank (r,s) broadcasts the transpose of its block along grid row r and
+ *   rank (s,c) broadcasts its block along grid column c, so rank (r,c) can
+ *   add A(i,block s)*A(block s,j) to every nonzero (i,j) of its own block
+ *   with the sequential intersection kernel. No rank ever needs a whole
+ *   adjacency list of a hub, only the parts that fall inside one block.
+ *   The row sums of C are reduced along the grid rows onto the diagonal.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <mpi.h>
+#include "reorder.h"
+#include "canon.h"
+#include "spgemm.h"
+#include "dist.h"
+#include "mpi2d.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Block CSC from (row, col) pairs already made local, rows sorted per column */
+static void block_csc(
+  uint32_t const * const pairs,
+  uint32_t const         nnz,
+  uint32_t const         cols,
+  uint32_t            ** col_ptr,
+  uint32_t            ** row_idx
+) {
+  uint32_t *col = calloc(cols + 1, sizeof(uint32_t));
+  uint32_t *row = malloc((nnz + 1) * sizeof(uint32_t));
+
+  for (uint32_t l = 0; l < nnz; l++) col[pairs[2*l+1] + 1]++;
+  for (uint32_t c = 0; c < cols; c++) col[c+1] += col[c];
+  for (uint32_t l = 0; l < nnz; l++) row[col[pairs[2*l+1]]++] = pairs[2*l];
+  for (uint32_t c = cols; c > 0; c--) col[c] = col[c-1];
+  col[0] = 0;
+  reorder_sort_columns(row, col, cols);
+
+  *col_ptr = col;
+  *row_idx = row;
+}
+
+/* Transpose of a sorted block CSC, sorted again since columns are visited in order */
+static void block_transpose(
+  uint32_t const * const col,
+  uint32_t const * const row,
+  uint32_t const         rows,
+  uint32_t const         cols,
+  uint32_t            ** t_col,
+  uint32_t            ** t_row
+) {
+  uint32_t nnz = col[cols];
+  uint32_t *tc = calloc(rows + 1, sizeof(uint32_t));
+  uint32_t *tr = malloc((nnz + 1) * sizeof(uint32_t));
+
+  for (uint32_t l = 0; l < nnz; l++) tc[row[l] + 1]++;
+  for (uint32_t i = 0; i < rows; i++) tc[i+1] += tc[i];
+  for (uint32_t j = 0; j < cols; j++)
+    for (uint32_t l = col[j]; l < col[j+1]; l++) tr[tc[row[l]]++] = j;
+  for (uint32_t i = rows; i > 0; i--) tc[i] = tc[i-1];
+  tc[0] = 0;
+
+  *t_col = tc;
+  *t_row = tr;
+}
+
+static uint32_t block_of(mpi2d_grid const * const g, uint32_t const v) {
+  uint32_t b = (uint64_t)v * g->q / g->n;
+  while (b > 0 && g->bound[b] > v) b--;
+  while (g->bound[b+1] <= v) b++;
+  return b;
+}
+
+/**
+ *  \brief Rank 0 reads the file, every rank receives its block of A
+ *
+ *  Rank 0 runs the edges through canon_coo before they are split into
+ *  blocks, so repeats and the second triangle of a general file are
+ *  dropped there.
+ *  Returns 0 on success on every rank, 1 if the file cannot be read or the
+ *  number of ranks is not a square.
+ */
+int mpi2d_load_mtx(
+  const char * const     filename,
+  MPI_Comm const         comm,
+  mpi2d_grid           * g,
+  dist_stats           * st
+) {
+  double start = MPI_Wtime();
+  int rank, size;
+  uint32_t *pairs = NULL;
+  int *sendcounts = NULL, *displs = NULL;
+  uint32_t header[2] = { 0, 0 };
+
+  memset(g, 0, sizeof(mpi2d_grid));
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  g->q = (int)(sqrt((double)size) + 0.5);
+  if (g->q * g->q != size) {
+    if (rank == 0) printf("The 2D engine needs a square number of ranks, not %d\n", size);
+    return 1;
+  }
+  g->comm = comm;
+  g->row = rank / g->q;
+  g->col = rank % g->q;
+  MPI_Comm_split(comm, g->row, g->col, &g->row_comm);
+  MPI_Comm_split(comm, g->col, g->row, &g->col_comm);
+  g->bound = malloc((g->q + 1) * sizeof(uint32_t));
+
+  if (rank == 0) {
+    uint32_t *I, *J;
+    int N, nz;
+
+    if (dist_read_mtx(filename, &I, &J, &nz, &N) != 0) {
+      printf("Could not read %s\n", filename);
+    }
+    else {
+      // ----- every edge once, so each block gets it once per orientation
+      canon_stats cs;
+      nz = canon_coo(I, J, nz, N, &cs);
+
+      g->n = N;
+      for (int b = 0; b <= g->q; b++) g->bound[b] = (uint64_t)N * b / g->q;
+
+      // ----- both orientations of every edge go to the owner of (row, col)
+      sendcounts = calloc(size, sizeof(int));
+      displs = calloc(size + 1, sizeof(int));
+      for (int i = 0; i < nz; i++) {
+        uint32_t bi = block_of(g, I[i]), bj = block_of(g, J[i]);
+        sendcounts[bi * g->q + bj] += 2;
+        sendcounts[bj * g->q + bi] += 2;
+      }
+      for (int p = 0; p < size; p++) displs[p+1] = displs[p] + sendcounts[p];
+      pairs = malloc((displs[size] + 1) * sizeof(uint32_t));
+      int *fill = malloc(size * sizeof(int));
+      memcpy(fill, displs, size * sizeof(int));
+      for (int i = 0; i < nz; i++) {
+        uint32_t bi = block_of(g, I[i]), bj = block_of(g, J[i]);
+        int p = bi * g->q + bj;
+        pairs[fill[p]++] = I[i] - g->bound[bi];
+        pairs[fill[p]++] = J[i] - g->bound[bj];
+        p = bj * g->q + bi;
+        pairs[fill[p]++] = J[i] - g->bound[bj];
+        pairs[fill[p]++] = I[i] - g->bound[bi];
+      }
+      free(fill);
+      free(I);
+      free(J);
+      header[0] = 1;
+      header[1] = N;
+    }
+  }
+
+  MPI_Bcast(header, 2, MPI_UINT32_T, 0, comm);
+  if (!header[0]) return 1;
+  g->n = header[1];
+  MPI_Bcast(g->bound, g->q + 1, MPI_UINT32_T, 0, comm);
+
+  int count;
+  MPI_Scatter(sendcounts, 1, MPI_INT, &count, 1, MPI_INT, 0, comm);
+  uint32_t *mine = malloc((count + 1) * sizeof(uint32_t));
+  MPI_Scatterv(pairs, sendcounts, displs, MPI_UINT32_T, mine, count, MPI_UINT32_T, 0, comm);
+  if (rank == 0) st->bytes[DIST_LOAD] += (uint64_t)displs[size] * sizeof(uint32_t);
+
+  uint32_t rows = g->bound[g->row + 1] - g->bound[g->row];
+  uint32_t cols = g->bound[g->col + 1] - g->bound[g->col];
+  g->nnz = count / 2;
+  block_csc(mine, g->nnz, cols, &g->a_col, &g->a_row);
+  block_transpose(g->a_col, g->a_row, rows, cols, &g->t_col, &g->t_row);
+
+  free(mine);
+  free(pairs);
+  free(sendcounts);
+  free(displs);
+
+  st->time[DIST_LOAD] += MPI_Wtime() - start;
+  return 0;
+}
+
+/* Broadcast a block CSC of the given number of columns from root, reusing the buffers */
+static void bcast_block(
+  uint32_t            ** col,
+  uint32_t            ** row,
+  uint32_t const         cols,
+  int const              root,
+  MPI_Comm const         comm,
+  uint64_t       * const bytes
+) {
+  int rank, size;
+  uint32_t nnz = 0;
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  if (rank == root) nnz = (*col)[cols];
+  MPI_Bcast(&nnz, 1, MPI_UINT32_T, root, comm);
+  if (rank != root) {
+    *col = realloc(*col, (cols + 1) * sizeof(uint32_t));
+    *row = realloc(*row, (nnz + 1) * sizeof(uint32_t));
+  }
+  MPI_Bcast(*col, cols + 1, MPI_UINT32_T, root, comm);
+  MPI_Bcast(*row, nnz, MPI_UINT32_T, root, comm);
+  if (rank == root) *bytes += (uint64_t)(size - 1) * (cols + 2 + nnz) * sizeof(uint32_t);
+}
+
+uint64_t mpi2d_count(
+  mpi2d_grid const * const g,
+  int              * const c3,
+  int const                workers,
+  dist_stats       * const st
+) {
+  uint32_t rows = g->bound[g->row + 1] - g->bound[g->row];
+  uint32_t cols = g->bound[g->col + 1] - g->bound[g->col];
+  uint32_t *c_values = calloc(g->nnz + 1, sizeof(uint32_t));
+  uint32_t *l_col = NULL, *l_row = NULL;   /* A(block r, block s) transposed */
+  uint32_t *r_col = NULL, *r_row = NULL;   /* A(block s, block c) */
+  double start;
+
+#ifdef _OPENMP
+  omp_set_dynamic(0);
+  omp_set_num_threads(workers);
+#endif
+
+  for (int s = 0; s < g->q; s++) {
+    start = MPI_Wtime();
+    uint32_t *lc = (g->col == s) ? g->t_col : l_col, *lr = (g->col == s) ? g->t_row : l_row;
+    uint32_t *rc = (g->row == s) ? g->a_col : r_col, *rr = (g->row == s) ? g->a_row : r_row;
+    bcast_block(&lc, &lr, rows, s, g->row_comm, &st->bytes[DIST_EXCHANGE]);
+    bcast_block(&rc, &rr, cols, s, g->col_comm, &st->bytes[DIST_EXCHANGE]);
+    if (g->col != s) { l_col = lc; l_row = lr; }
+    if (g->row != s) { r_col = rc; r_row = rr; }
+    st->time[DIST_EXCHANGE] += MPI_Wtime() - start;
+
+    // ----- C(i,j) += |A(i,block s) .* A(block s,j)| on the own mask
+    start = MPI_Wtime();
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (uint32_t j = 0; j < cols; j++)
+      for (uint32_t p = g->a_col[j]; p < g->a_col[j+1]; p++) {
+        uint32_t i = g->a_row[p];
+        c_values[p] += spgemm_intersect_lists(lr + lc[i], lc[i+1] - lc[i],
+                                              rr + rc[j], rc[j+1] - rc[j]);
+      }
+    st->time[DIST_COUNT] += MPI_Wtime() - start;
+  }
+
+  // ----- row sums of C reduced along the grid row onto the diagonal rank
+  start = MPI_Wtime();
+  int *local = calloc(rows + 1, sizeof(int));
+  uint64_t sum = 0;
+  for (uint32_t p = 0; p < g->nnz; p++) {
+    local[g->a_row[p]] += c_values[p];
+    sum += c_values[p];
+  }
+  MPI_Reduce(local, c3, rows, MPI_INT, MPI_SUM, g->row, g->row_comm);
+  if (g->row == g->col)
+    for (uint32_t i = 0; i < rows; i++) c3[i] /= 2;
+  MPI_Allreduce(MPI_IN_PLACE, &sum, 1, MPI_UINT64_T, MPI_SUM, g->comm);
+  if (g->row != g->col) st->bytes[DIST_REDUCE] += rows * sizeof(int);
+  st->bytes[DIST_REDUCE] += sizeof(uint64_t);
+  st->time[DIST_REDUCE] += MPI_Wtime() - start;
+
+  free(local);
+  free(c_values);
+  free(l_col); free(l_row);
+  free(r_col); free(r_row);
+
+  /* every triangle is seen on its six nonzeros */
+  return sum / 6;
+}
+
+void mpi2d_free(mpi2d_grid *g) {
+  if (g->bound != NULL) {
+    MPI_Comm_free(&g->row_comm);
+    MPI_Comm_free(&g->col_comm);
+  }
+  free(g->bound);
+  free(g->a_col);
+  free(g->a_row);
+  free(g->t_col);
+  free(g->t_row);
+}
@@ -0,0 +1,43 @@
+#ifndef MPI2D_H
+#define MPI2D_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <mpi.h>
+#include "dist.h"
+
+/* A on a q x q process grid, rank (r,c) holds the block of rows r and columns c */
+typedef struct {
+  MPI_Comm  comm;      /*!< All ranks of the grid */
+  int       q;         /*!< Grid dimension, the number of ranks is q*q */
+  int       row;       /*!< Grid row of this rank */
+  int       col;       /*!< Grid column of this rank */
+  MPI_Comm  row_comm;  /*!< Ranks of the same grid row, ordered by column */
+  MPI_Comm  col_comm;  /*!< Ranks of the same grid column, ordered by row */
+  uint32_t  n;         /*!< Number of vertices */
+  uint32_t *bound;     /*!< Vertex boundaries of the blocks (q+1) */
+  uint32_t  nnz;       /*!< Nonzeros of the own block */
+  uint32_t *a_col;     /*!< Own block, CSC with block-local indices */
+  uint32_t *a_row;
+  uint32_t *t_col;     /*!< Transpose of the own block, CSC */
+  uint32_t *t_row;
+} mpi2d_grid;
+
+int mpi2d_load_mtx(
+  const char * const     filename,  /*!< Matrix Market file, read by rank 0 */
+  MPI_Comm const         comm,      /*!< Must hold a square number of ranks */
+  mpi2d_grid           * g,
+  dist_stats           * st
+);
+
+uint64_t mpi2d_count(
+  mpi2d_grid const * const g,
+  int              * const c3,      /*!< Triangles of block row r, filled on the diagonal rank (r,r) */
+  int const                workers, /*!< OpenMP threads of this rank */
+  dist_stats       * const st
+);
+
+void mpi2d_free(mpi2d_grid *g);
+
+#endif
@@ -0,0 +1,393 @@
+/**
+ *   \file ooc.c
+ *   \brief Out-of-core triangle counting on column shards of L
+ *
+ *   The strictly lower half L is cut into column ranges (shards) small
+ *   enough that OOC_RESIDENT_SHARDS of them fit in the memory budget.
+ *   Each shard is written to disk as a sorted CSC. A triangle j < k < i
+ *   is found from column j (shard a) and column k (shard b >= a), so
+ *   streaming every pair a <= b counts each triangle exactly once. While
+ *   a pair is being counted the next shard is read by a helper thread.
+ *
+ *   Only vertex-sized arrays (c3 and the markers) stay in memory for the
+ *   whole run; edges never do.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "mmio.h"
+#include "reorder.h"
+#include "canon.h"
+#include "ooc.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/*****************************************************************************/
+/*                                  sharding                                 */
+/*****************************************************************************/
+
+static void shard_path(char *path, size_t size, const char *dir, const char *kind, uint32_t s) {
+  snprintf(path, size, "%s/%s_%u.bin", dir, kind, s);
+}
+
+static int read_entry(FILE *f, int pattern, uint32_t *i, uint32_t *j) {
+  double val;
+  int ok;
+  if (pattern) ok = fscanf(f, "%u %u\n", i, j) == 2;
+  else         ok = fscanf(f, "%u %u %lg\n", i, j, &val) == 3;
+  (*i)--;  /* adjust from 1-based to 0-based */
+  (*j)--;
+  return ok;
+}
+
+static uint32_t shard_of(ooc_graph const *g, uint32_t column) {
+  uint32_t lo = 0, hi = g->shards - 1;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo + 1) / 2;
+    if (g->bound[mid] <= column) lo = mid;
+    else                         hi = mid - 1;
+  }
+  return lo;
+}
+
+/**
+ *  \brief Split the Matrix Market file into sorted CSC shards of L on disk
+ *
+ *  Pass 1 counts the column sizes of L and places the shard boundaries,
+ *  pass 2 appends every edge to the bucket file of its shard, and pass 3
+ *  turns one bucket at a time into a sorted CSC shard file. Repeated
+ *  edges, both triangles of a general file included, go through canon_coo
+ *  there and are stored once.
+ */
+ooc_graph *ooc_shard_mtx(
+  const char * const     filename,
+  const char * const     dir,
+  uint64_t const         budget
+) {
+  MM_typecode matcode;
+  int M, N, nz;
+  FILE *f;
+  char path[1100];
+
+  if ((f = fopen(filename, "r")) == NULL) return NULL;
+  if (mm_read_banner(f, &matcode) != 0 || mm_read_mtx_crd_size(f, &M, &N, &nz) != 0) {
+    fclose(f);
+    return NULL;
+  }
+  int pattern = mm_is_pattern(matcode);
+  long data = ftell(f);
+
+  ooc_graph *g = calloc(1, sizeof(ooc_graph));
+  g->n = N;
+  snprintf(g->dir, sizeof(g->dir), "%s", dir);
+
+  // ----- pass 1: column sizes of L, a short or malformed file fails here
+  uint32_t *degree = calloc(N, sizeof(uint32_t));
+  for (int l = 0; l < nz; l++) {
+    uint32_t i, j;
+    if (!read_entry(f, pattern, &i, &j)) {
+      free(degree);
+      free(g);
+      fclose(f);
+      return NULL;
+    }
+    if (i != j && i < (uint32_t)N && j < (uint32_t)N) degree[i < j ? i : j]++;
+  }
+
+  /* Rows plus column pointers of one shard, with OOC_RESIDENT_SHARDS in memory */
+  uint64_t shard_bytes = budget / OOC_RESIDENT_SHARDS;
+  g->bound = malloc((N + 2) * sizeof(uint32_t));
+  uint32_t *shard_nnz = malloc((N + 1) * sizeof(uint32_t));
+  g->bound[0] = 0;
+  g->shards = 0;
+  uint64_t bytes = 0;
+  uint32_t count = 0;
+  for (uint32_t v = 0; v < (uint32_t)N; v++) {
+    uint64_t cost = sizeof(uint32_t) * ((uint64_t)degree[v] + 1);
+    if (bytes + cost > shard_bytes && v > g->bound[g->shards]) {
+      shard_nnz[g->shards] = count;
+      g->bound[++g->shards] = v;
+      bytes = 0;
+      count = 0;
+    }
+    bytes += cost;
+    count += degree[v];
+  }
+  shard_nnz[g->shards] = count;
+  g->bound[++g->shards] = N;
+  free(degree);
+
+  // ----- pass 2: scatter the edges, oriented as (row = max, col = min), into buckets
+  FILE **bucket = malloc(g->shards * sizeof(FILE *));
+  for (uint32_t s = 0; s < g->shards; s++) {
+    shard_path(path, sizeof(path), dir, "bucket", s);
+    bucket[s] = fopen(path, "wb");
+    if (bucket[s] == NULL) {
+      fprintf(stderr, "Cannot write %s\n", path);
+      exit(1);
+    }
+  }
+  fseek(f, data, SEEK_SET);
+  for (int l = 0; l < nz; l++) {
+    uint32_t e[2], i, j;
+    if (!read_entry(f, pattern, &i, &j)) break;
+    if (i == j || i >= (uint32_t)N || j >= (uint32_t)N) continue;
+    e[0] = i > j ? i : j;
+    e[1] = i < j ? i : j;
+    fwrite(e, sizeof(uint32_t), 2, bucket[shard_of(g, e[1])]);
+  }
+  for (uint32_t s = 0; s < g->shards; s++) fclose(bucket[s]);
+  free(bucket);
+  fclose(f);
+
+  // ----- pass 3: one bucket at a time into a sorted CSC shard, repeats dropped
+  for (uint32_t s = 0; s < g->shards; s++) {
+    uint32_t first = g->bound[s], columns = g->bound[s+1] - first, nnz = shard_nnz[s];
+    uint32_t *hi = malloc(((uint64_t)nnz + 1) * sizeof(uint32_t));
+    uint32_t *lo = malloc(((uint64_t)nnz + 1) * sizeof(uint32_t));
+    uint32_t *col = calloc(columns + 1, sizeof(uint32_t));
+    canon_stats cs;
+
+    shard_path(path, sizeof(path), dir, "bucket", s);
+    f = fopen(path, "rb");
+    for (uint32_t l = 0; l < nnz; l++) {
+      uint32_t e[2];
+      if (fread(e, sizeof(uint32_t), 2, f) != 2) {
+        fprintf(stderr, "Short read on %s\n", path);
+        exit(1);
+      }
+      hi[l] = e[0] - first;   /* both shifted, so canon_coo only buckets this shard's columns */
+      lo[l] = e[1] - first;
+    }
+    fclose(f);
+    remove(path);
+
+    // a general file lists every edge twice, a symmetric one may repeat it
+    nnz = canon_coo(hi, lo, nnz, columns, &cs);
+    for (uint32_t l = 0; l < nnz; l++) {
+      col[lo[l] + 1]++;
+      hi[l] += first;
+    }
+    for (uint32_t c = 0; c < columns; c++) col[c+1] += col[c];
+    uint32_t *row = hi;
+
+    uint32_t header[3] = { first, first + columns, nnz };
+    shard_path(path, sizeof(path), dir, "shard", s);
+    f = fopen(path, "wb");
+    fwrite(header, sizeof(uint32_t), 3, f);
+    fwrite(col, sizeof(uint32_t), columns + 1, f);
+    fwrite(row, sizeof(uint32_t), nnz, f);
+    fclose(f);
+
+    free(hi);
+    free(lo);
+    free(col);
+  }
+  free(shard_nnz);
+
+  return g;
+}
+
+ooc_shard *ooc_shard_load(ooc_graph *g, uint32_t const s) {
+  char path[1100];
+  uint32_t header[3];
+
+  shard_path(path, sizeof(path), g->dir, "shard", s);
+  FILE *f = fopen(path, "rb");
+  if (f == NULL || fread(header, sizeof(uint32_t), 3, f) != 3) {
+    fprintf(stderr, "Cannot read %s\n", path);
+    exit(1);
+  }
+
+  ooc_shard *shard = malloc(sizeof(ooc_shard));
+  shard->first = header[0];
+  shard->last  = header[1];
+  shard->nnz   = header[2];
+  shard->col   = malloc((shard->last - shard->first + 1) * sizeof(uint32_t));
+  shard->row   = malloc((uint64_t)shard->nnz * sizeof(uint32_t));
+
+  size_t columns = shard->last - shard->first + 1;
+  if (fread(shard->col, sizeof(uint32_t), columns, f) != columns ||
+      fread(shard->row, sizeof(uint32_t), shard->nnz, f) != shard->nnz) {
+    fprintf(stderr, "Short read on %s\n", path);
+    exit(1);
+  }
+  fclose(f);
+
+  g->bytes_read += sizeof(header) + sizeof(uint32_t) * (columns + shard->nnz);
+  return shard;
+}
+
+void ooc_shard_free(ooc_shard *shard) {
+  if (shard == NULL) return;
+  free(shard->col);
+  free(shard->row);
+  free(shard);
+}
+
+void ooc_remove(ooc_graph *g) {
+  char path[1100];
+  for (uint32_t s = 0; s < g->shards; s++) {
+    shard_path(path, sizeof(path), g->dir, "shard", s);
+    remove(path);
+  }
+  free(g->bound);
+  free(g);
+}
+
+/*****************************************************************************/
+/*                                  counting                                 */
+/*****************************************************************************/
+
+/**
+ *  \brief Triangles j < k < i with j in [j_first, j_last) of shard a and k in shard b
+ *
+ *  Same wedge closure as lowertri_count_range, with the columns of k
+ *  looked up in shard b. The marker is tagged with j, so rescattering
+ *  column j for every shard b is harmless.
+ */
+uint64_t ooc_count_pair(
+  ooc_shard const * const a,
+  ooc_shard const * const b,
+  uint32_t const         j_first,
+  uint32_t const         j_last,
+  uint32_t       * const marker,
+  int            * const c3
+) {
+  uint64_t triangles = 0;
+
+  for (uint32_t j = j_first; j < j_last; j++) {
+    uint32_t const *rows = a->row + a->col[j - a->first];
+    uint32_t const  size = a->col[j - a->first + 1] - a->col[j - a->first];
+    uint32_t column_hits = 0;
+
+    for (uint32_t p = 0; p < size; p++) marker[rows[p]] = j;
+
+    for (uint32_t p = 0; p < size; p++) {
+      uint32_t k = rows[p];
+      if (k < b->first) continue;
+      if (k >= b->last) break;   /* rows are sorted */
+
+      uint32_t hits = 0;
+      for (uint32_t q = b->col[k - b->first]; q < b->col[k - b->first + 1]; q++) {
+        uint32_t i = b->row[q];
+        if (marker[i] == j) {
+          hits++;
+          c3[i]++;
+        }
+      }
+      c3[k] += hits;
+      column_hits += hits;
+    }
+
+    c3[j] += column_hits;
+    triangles += column_hits;
+  }
+
+  return triangles;
+}
+
+typedef struct {
+  ooc_graph *g;
+  uint32_t   s;
+  ooc_shard *shard;
+} prefetch_request;
+
+static void *prefetch(void *arg) {
+  prefetch_request *req = arg;
+  req->shard = ooc_shard_load(req->g, req->s);
+  return NULL;
+}
+
+/**
+ *  \brief Stream every shard pair a <= b and count, reading ahead one shard
+ *
+ *  The shard read next is the b of the following pair, or the next row
+ *  shard a+1 once b reaches the last shard.
+ */
+uint64_t ooc_count(
+  ooc_graph            * g,
+  int            * const c3,
+  int const              workers
+) {
+  uint32_t n = g->n, S = g->shards;
+  uint64_t triangles = 0;
+  uint32_t **marker = malloc(workers * sizeof(uint32_t *));
+  int **local_c3 = malloc(workers * sizeof(int *));
+  pthread_t loader;
+  prefetch_request req = { g, 0, NULL };
+  int pending = 0;
+
+  for (int w = 0; w < workers; w++) {
+    marker[w] = malloc(n * sizeof(uint32_t));
+    for (uint32_t v = 0; v < n; v++) marker[w][v] = UINT32_MAX;
+    local_c3[w] = calloc(n, sizeof(int));
+  }
+
+#ifdef _OPENMP
+  omp_set_dynamic(0);
+  omp_set_num_threads(workers);
+#endif
+
+  ooc_shard *A = ooc_shard_load(g, 0);
+  ooc_shard *next_A = NULL;
+
+  for (uint32_t a = 0; a < S; a++) {
+    for (uint32_t b = a; b < S; b++) {
+      ooc_shard *B = A;
+      if (b != a) {
+        pthread_join(loader, NULL);
+        pending = 0;
+        B = req.shard;
+      }
+
+      /* The last column shard of a row is also the next row shard when b == a+1 */
+      int last_of_row = b + 1 == S;
+      int reuse_B = last_of_row && b == a + 1;
+      if (!last_of_row || (a + 1 < S && !reuse_B)) {
+        req.s = last_of_row ? a + 1 : b + 1;
+        pthread_create(&loader, NULL, prefetch, &req);
+        pending = 1;
+      }
+
+      #pragma omp parallel for schedule(dynamic, 64) reduction(+:triangles)
+      for (uint32_t j = A->first; j < A->last; j++) {
+        int w = 0;
+#ifdef _OPENMP
+        w = omp_get_thread_num();
+#endif
+        triangles += ooc_count_pair(A, B, j, j + 1, marker[w], local_c3[w]);
+      }
+
+      if (reuse_B)     next_A = B;
+      else if (B != A) ooc_shard_free(B);
+    }
+
+    ooc_shard_free(A);
+    A = next_A;
+    next_A = NULL;
+    if (pending) {
+      pthread_join(loader, NULL);
+      pending = 0;
+      A = req.shard;
+    }
+  }
+
+  for (uint32_t v = 0; v < n; v++)
+    for (int w = 0; w < workers; w++)
+      c3[v] += local_c3[w][v];
+
+  for (int w = 0; w < workers; w++) {
+    free(marker[w]);
+    free(local_c3[w]);
+  }
+  free(marker);
+  free(local_c3);
+
+  return triangles;
+}
@@ -0,0 +1,54 @@
+#ifndef OOC_H
+#define OOC_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Shards held in memory at once: the row shard, the current and the prefetched column shard */
+#define OOC_RESIDENT_SHARDS 3
+
+typedef struct {
+  uint32_t  first;     /*!< First column of the shard */
+  uint32_t  last;      /*!< One past the last column */
+  uint32_t  nnz;       /*!< Nonzeros of L in the shard */
+  uint32_t *col;       /*!< Local column start indices (last-first+1) */
+  uint32_t *row;       /*!< Row indices, sorted per column */
+} ooc_shard;
+
+typedef struct {
+  uint32_t  n;         /*!< Number of vertices */
+  uint32_t  shards;    /*!< Number of shards */
+  uint32_t *bound;     /*!< Column boundaries of the shards (shards+1) */
+  char      dir[1024]; /*!< Directory holding the shard files */
+  uint64_t  bytes_read;/*!< Shard bytes read back while counting */
+} ooc_graph;
+
+ooc_graph *ooc_shard_mtx(
+  const char * const     filename,  /*!< Matrix Market file, one triangle */
+  const char * const     dir,       /*!< Directory for the shard files */
+  uint64_t const         budget     /*!< Memory budget for edges (bytes) */
+);
+
+ooc_shard *ooc_shard_load(ooc_graph *g, uint32_t const s);
+
+void ooc_shard_free(ooc_shard *shard);
+
+uint64_t ooc_count_pair(
+  ooc_shard const * const a,        /*!< Shard of the smallest vertex j */
+  ooc_shard const * const b,        /*!< Shard of the middle vertex k */
+  uint32_t const         j_first,   /*!< First column of a to count */
+  uint32_t const         j_last,    /*!< One past the last column */
+  uint32_t       * const marker,    /*!< Per worker marker, n slots */
+  int            * const c3         /*!< Per worker triangles per vertex */
+);
+
+uint64_t ooc_count(
+  ooc_graph            * g,
+  int            * const c3,        /*!< Triangles per vertex (n), zeroed */
+  int const              workers    /*!< Number of OpenMP threads */
+);
+
+void ooc_remove(ooc_graph *g);
+
+#endif
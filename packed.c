@@ -0,0 +1,219 @@
+/**
+ *   \file packed.c
+ *   \brief Compressed CSC: gaps of the sorted rows, bit-packed per block
+ *
+ *   Once the threads saturate the memory bus, reading cscRow costs more
+ *   than the merge itself. Consecutive rows of a sorted column are close,
+ *   so their gaps fit in far fewer than 32 bits, the more so after a
+ *   reordering that keeps neighbours together. Every block of
+ *   PACKED_BLOCK rows stores its first row in full and the gaps at the
+ *   width of its largest one, so a block decodes on its own into a small
+ *   array on the stack and the intersection merges straight from there.
+ *   The first row of the next block tells whether a block lies wholly
+ *   below the other list, such blocks are skipped without decoding.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "work.h"
+#include "packed.h"
+
+static uint32_t bits_for(uint32_t const x) {
+  return x ? 32 - __builtin_clz(x) : 0;
+}
+
+/* Width of the gaps of a block, rows strictly increasing */
+static uint32_t block_width(uint32_t const * const rows, uint32_t const count) {
+  uint32_t any = 0;
+  for (uint32_t k = 1; k < count; k++) any |= rows[k] - rows[k-1] - 1;
+  return bits_for(any);
+}
+
+static uint32_t block_words(uint32_t const count, uint32_t const width) {
+  return 1 + ((count - 1) * width + 31) / 32;
+}
+
+static uint64_t column_words(uint32_t const * const rows, uint32_t const degree) {
+  uint32_t blocks = (degree + PACKED_BLOCK - 1) / PACKED_BLOCK;
+  uint64_t words = (blocks + 3) / 4;
+
+  for (uint32_t b = 0; b < blocks; b++) {
+    uint32_t first = b * PACKED_BLOCK;
+    uint32_t count = degree - first < PACKED_BLOCK ? degree - first : PACKED_BLOCK;
+    words += block_words(count, block_width(rows + first, count));
+  }
+  return words;
+}
+
+static void encode_column(uint32_t const * const rows, uint32_t const degree, uint32_t *out) {
+  uint32_t blocks = (degree + PACKED_BLOCK - 1) / PACKED_BLOCK;
+  uint32_t *widths = out;
+
+  memset(widths, 0, (blocks + 3) / 4 * sizeof(uint32_t));
+  out += (blocks + 3) / 4;
+  for (uint32_t b = 0; b < blocks; b++) {
+    uint32_t first = b * PACKED_BLOCK;
+    uint32_t count = degree - first < PACKED_BLOCK ? degree - first : PACKED_BLOCK;
+    uint32_t width = block_width(rows + first, count);
+    uint64_t pending = 0;
+    uint32_t filled = 0;
+
+    widths[b / 4] |= width << (8 * (b % 4));
+    *out++ = rows[first];
+    for (uint32_t k = 1; k < count && width > 0; k++) {
+      pending |= (uint64_t)(rows[first + k] - rows[first + k - 1] - 1) << filled;
+      filled += width;
+      if (filled >= 32) {
+        *out++ = (uint32_t)pending;
+        pending >>= 32;
+        filled -= 32;
+      }
+    }
+    if (filled > 0) *out++ = (uint32_t)pending;
+  }
+}
+
+/**
+ *  \brief Pack the rows of every column, the columns in parallel
+ */
+packed_csc *packed_build(
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         n
+) {
+  packed_csc *pc = malloc(sizeof(packed_csc));
+  pc->n = n;
+  pc->start = malloc(((size_t)n + 1) * sizeof(uint64_t));
+
+  // ----- words per column, then their starts
+  pc->start[0] = 0;
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (uint32_t j = 0; j < n; j++)
+    pc->start[j+1] = column_words(cscRow + cscColumn[j], cscColumn[j+1] - cscColumn[j]);
+  for (uint32_t j = 0; j < n; j++) pc->start[j+1] += pc->start[j];
+
+  /* The decoder reads one word past a block, the spare words keep that inside */
+  pc->words = malloc((pc->start[n] + 2) * sizeof(uint32_t));
+  pc->words[pc->start[n]] = pc->words[pc->start[n] + 1] = 0;
+  pc->bytes = ((size_t)n + 1) * sizeof(uint64_t) + (pc->start[n] + 2) * sizeof(uint32_t);
+
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (uint32_t j = 0; j < n; j++)
+    encode_column(cscRow + cscColumn[j], cscColumn[j+1] - cscColumn[j], pc->words + pc->start[j]);
+  return pc;
+}
+
+void packed_free(packed_csc *pc) {
+  if (pc == NULL) return;
+  free(pc->start);
+  free(pc->words);
+  free(pc);
+}
+
+/* Rows of one block into out, the gaps read through a 64 bit window */
+static inline void decode_block(uint32_t const * const p, uint32_t const width, uint32_t const count,
+                                uint32_t * const out) {
+  uint32_t row = p[0];
+  uint32_t const *gaps = p + 1;
+  uint64_t mask = (1ull << width) - 1;
+
+  out[0] = row;
+  for (uint32_t k = 1, bit = 0; k < count; k++, bit += width) {
+    uint64_t window = gaps[bit / 32] | (uint64_t)gaps[bit / 32 + 1] << 32;
+    row += ((window >> (bit % 32)) & mask) + 1;
+    out[k] = row;
+  }
+}
+
+static inline uint32_t block_width_of(uint32_t const * const widths, uint32_t const b) {
+  return (widths[b / 4] >> (8 * (b % 4))) & 0xff;
+}
+
+uint32_t packed_decode(
+  packed_csc     const * const pc,
+  uint32_t const * const cscColumn,
+  uint32_t const         j,
+  uint32_t       * const rows
+) {
+  uint32_t degree = cscColumn[j+1] - cscColumn[j];
+  uint32_t blocks = (degree + PACKED_BLOCK - 1) / PACKED_BLOCK;
+  uint32_t const *widths = pc->words + pc->start[j];
+  uint32_t const *p = widths + (blocks + 3) / 4;
+
+  for (uint32_t b = 0; b < blocks; b++) {
+    uint32_t count = degree - b * PACKED_BLOCK < PACKED_BLOCK ? degree - b * PACKED_BLOCK : PACKED_BLOCK;
+    uint32_t width = block_width_of(widths, b);
+    decode_block(p, width, count, rows + b * PACKED_BLOCK);
+    p += block_words(count, width);
+  }
+  return degree;
+}
+
+/* Common rows of a sorted list and packed column i, decoded a block at a time */
+static uint32_t intersect_packed(
+  uint32_t const * const a,
+  uint32_t const         na,
+  packed_csc     const * const pc,
+  uint32_t const * const cscColumn,
+  uint32_t const         i
+) {
+  uint32_t degree = cscColumn[i+1] - cscColumn[i];
+  uint32_t blocks = (degree + PACKED_BLOCK - 1) / PACKED_BLOCK;
+  uint32_t const *widths = pc->words + pc->start[i];
+  uint32_t const *p = widths + (blocks + 3) / 4;
+  uint32_t block[PACKED_BLOCK];
+  uint32_t value = 0, pa = 0, stepped = 0;
+
+  for (uint32_t b = 0; b < blocks && pa < na; b++) {
+    uint32_t count = degree - b * PACKED_BLOCK < PACKED_BLOCK ? degree - b * PACKED_BLOCK : PACKED_BLOCK;
+    uint32_t width = block_width_of(widths, b);
+    uint32_t words = block_words(count, width);
+
+    /* The next block starts at or below a[pa], nothing in this one can match */
+    if (b + 1 < blocks && p[words] <= a[pa]) {
+      p += words;
+      continue;
+    }
+    decode_block(p, width, count, block);
+    p += words;
+
+    uint32_t k = 0;
+    while (k < count && pa < na) {
+      if (block[k] == a[pa]) {
+        value++;
+        k++;
+        pa++;
+      }
+      else if (block[k] < a[pa]) k++;
+      else                       pa++;
+    }
+    stepped += k;
+  }
+  WORK_ADD(intersections, 1);
+  WORK_ADD(compared, stepped + pa);
+  WORK_ADD(hits, value);
+  WORK_SIZE(na + degree);
+  (void)stepped;
+  return value;
+}
+
+/* C(i,j) = |A(:,i) .* A(:,j)| for every nonzero (i,j) of the column range */
+void packed_dot(
+  packed_csc     const * const pc,
+  uint32_t const * const cscColumn,
+  uint32_t const         start,
+  uint32_t const         end,
+  uint32_t       * const rows,
+  uint32_t       * const c_values
+) {
+  for (uint32_t j = start; j < end; j++) {
+    uint32_t degree = packed_decode(pc, cscColumn, j, rows);
+    for (uint32_t k = 0; k < degree; k++)
+      c_values[cscColumn[j] + k] = intersect_packed(rows, degree, pc, cscColumn, rows[k]);
+  }
+}
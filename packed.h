@@ -0,0 +1,47 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Rows per block, the block decodes into one small array */
+#define PACKED_BLOCK 32
+
+/*
+ *  Column j starts at word start[j]: the bit widths of its blocks as
+ *  bytes, four to a word, then every block as its first row followed by
+ *  the gaps minus one, bit-packed at the width of the block.
+ */
+typedef struct {
+  uint32_t  n;          /*!< Number of columns */
+  uint64_t *start;      /*!< First word of every column (n+1) */
+  uint32_t *words;      /*!< Packed columns, two spare words at the end */
+  size_t    bytes;      /*!< Memory of start and words */
+} packed_csc;
+
+packed_csc *packed_build(
+  uint32_t const * const cscRow,     /*!< CSC row indices, sorted and unique per column */
+  uint32_t const * const cscColumn,  /*!< CSC column start indices */
+  uint32_t const         n           /*!< Number of columns */
+);
+
+void packed_free(packed_csc *pc);
+
+uint32_t packed_decode(
+  packed_csc     const * const pc,
+  uint32_t const * const cscColumn,
+  uint32_t const         j,          /*!< Column */
+  uint32_t       * const rows        /*!< Rows of the column, out (degree) */
+);
+
+void packed_dot(
+  packed_csc     const * const pc,
+  uint32_t const * const cscColumn,
+  uint32_t const         start,      /*!< First column to compute */
+  uint32_t const         end,        /*!< One past the last column */
+  uint32_t       * const rows,       /*!< Per worker room for the longest column */
+  uint32_t       * const c_values    /*!< C value of every nonzero */
+);
+
+#endif
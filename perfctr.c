@@ -0,0 +1,149 @@
+/**
+ *   \file perfctr.c
+ *   \brief Per thread hardware counters through perf_event_open
+ *
+ *   Every thread opens its own counters the first time it reads them,
+ *   they count only that thread in user space and close when it exits.
+ *   An event the kernel refuses (perf_event_paranoid, no PMU in a VM,
+ *   not Linux) reads as PERFCTR_NONE and is printed as n/a, the timings
+ *   around it are unaffected.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "perfctr.h"
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+static const char *names[PERFCTR_EVENTS] = {
+  "cycles", "instructions", "LLC misses", "branch misses", "dTLB misses"
+};
+
+static const char *keys[PERFCTR_EVENTS] = {
+  "cycles", "instructions", "llc_misses", "branch_misses", "dtlb_misses"
+};
+
+static pthread_key_t  thread_key;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+
+/* File descriptors of the calling thread, -1 for refused events */
+typedef struct {
+  int fd[PERFCTR_EVENTS];
+} thread_counters;
+
+static void close_counters(void *arg) {
+  thread_counters *t = arg;
+  for (int e = 0; e < PERFCTR_EVENTS; e++) if (t->fd[e] >= 0) close(t->fd[e]);
+  free(t);
+}
+
+static void make_key(void) {
+  pthread_key_create(&thread_key, close_counters);
+}
+
+#ifdef __linux__
+static int open_event(int const event) {
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  switch (event) {
+    case PERFCTR_CYCLES:        attr.config = PERF_COUNT_HW_CPU_CYCLES;   break;
+    case PERFCTR_INSTRUCTIONS:  attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+    case PERFCTR_LLC_MISSES:    attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+    case PERFCTR_BRANCH_MISSES: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+    default:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      break;
+  }
+  /* This thread, any cpu, no group */
+  return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#else
+static int open_event(int const event) {
+  (void)event;
+  return -1;
+}
+#endif
+
+static thread_counters *counters(void) {
+  pthread_once(&key_once, make_key);
+  thread_counters *t = pthread_getspecific(thread_key);
+  if (t == NULL) {
+    t = malloc(sizeof(thread_counters));
+    for (int e = 0; e < PERFCTR_EVENTS; e++) t->fd[e] = open_event(e);
+    pthread_setspecific(thread_key, t);
+  }
+  return t;
+}
+
+/* 1 if at least one event counts on the calling thread */
+int perfctr_available(void) {
+  thread_counters *t = counters();
+  for (int e = 0; e < PERFCTR_EVENTS; e++) if (t->fd[e] >= 0) return 1;
+  return 0;
+}
+
+const char *perfctr_event_name(int event) {
+  return (event >= 0 && event < PERFCTR_EVENTS) ? names[event] : "unknown";
+}
+
+/* Running totals of the calling thread, scaled up when the PMU was multiplexed */
+void perfctr_read(perfctr_sample *s) {
+  thread_counters *t = counters();
+
+  for (int e = 0; e < PERFCTR_EVENTS; e++) {
+    uint64_t raw[3];
+    s->value[e] = PERFCTR_NONE;
+    if (t->fd[e] < 0 || read(t->fd[e], raw, sizeof(raw)) != sizeof(raw)) continue;
+    s->value[e] = (raw[2] > 0 && raw[2] < raw[1]) ? (uint64_t)((double)raw[0] * raw[1] / raw[2]) : raw[0];
+  }
+}
+
+/* sum += end - start, start NULL adds end itself; n/a anywhere stays n/a */
+void perfctr_add(perfctr_sample *sum, perfctr_sample const *end, perfctr_sample const *start) {
+  for (int e = 0; e < PERFCTR_EVENTS; e++) {
+    uint64_t from = start ? start->value[e] : 0;
+    if (end->value[e] == PERFCTR_NONE || from == PERFCTR_NONE) sum->value[e] = PERFCTR_NONE;
+    else if (sum->value[e] != PERFCTR_NONE) sum->value[e] += end->value[e] - from;
+  }
+}
+
+void perfctr_write_json(perfctr_sample const *s, FILE *f) {
+  for (int e = 0; e < PERFCTR_EVENTS; e++) {
+    if (s->value[e] == PERFCTR_NONE) fprintf(f, ", \"%s\": null", keys[e]);
+    else fprintf(f, ", \"%s\": %llu", keys[e], (unsigned long long)s->value[e]);
+  }
+}
+
+/**
+ *  \brief One line of counters: IPC and misses per intersection when known
+ */
+void perfctr_print(const char *label, perfctr_sample const *s, uint64_t const intersections) {
+  uint64_t const *v = s->value;
+
+  printf("\n%-10s", label);
+  if (v[PERFCTR_CYCLES] != PERFCTR_NONE && v[PERFCTR_INSTRUCTIONS] != PERFCTR_NONE && v[PERFCTR_CYCLES] > 0)
+    printf(" IPC %5.2f", (double)v[PERFCTR_INSTRUCTIONS] / v[PERFCTR_CYCLES]);
+  else
+    printf(" IPC   n/a");
+  for (int e = PERFCTR_LLC_MISSES; e < PERFCTR_EVENTS; e++) {
+    if (v[e] == PERFCTR_NONE)   printf("  %s n/a", names[e]);
+    else if (intersections > 0) printf("  %s %.3f/isect", names[e], (double)v[e] / intersections);
+    else                        printf("  %s %llu", names[e], (unsigned long long)v[e]);
+  }
+}
@@ -0,0 +1,35 @@
+#ifndef PERFCTR_H
+#define PERFCTR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Hardware events counted per thread */
+#define PERFCTR_CYCLES        0
+#define PERFCTR_INSTRUCTIONS  1
+#define PERFCTR_LLC_MISSES    2
+#define PERFCTR_BRANCH_MISSES 3
+#define PERFCTR_DTLB_MISSES   4
+#define PERFCTR_EVENTS        5
+
+/* Counter values, PERFCTR_NONE where the event could not be opened */
+#define PERFCTR_NONE UINT64_MAX
+
+typedef struct {
+  uint64_t  value[PERFCTR_EVENTS];
+} perfctr_sample;
+
+int perfctr_available(void);
+
+const char *perfctr_event_name(int event);
+
+void perfctr_read(perfctr_sample *s);
+
+void perfctr_add(perfctr_sample *sum, perfctr_sample const *end, perfctr_sample const *start);
+
+void perfctr_write_json(perfctr_sample const *s, FILE *f);
+
+void perfctr_print(const char *label, perfctr_sample const *s, uint64_t const intersections);
+
+#endif
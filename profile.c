@@ -0,0 +1,216 @@
+/**
+ *   \file profile.c
+ *   \brief Per-phase wall time, heap growth and peak RSS of a count
+ *
+ *   A phase runs from the last mark to profile_end, which adds its time
+ *   and sets the next mark, so back to back phases need one call each.
+ *   All calls take a NULL profile and do nothing, callers do not check.
+ *   Times come from CLOCK_MONOTONIC, heap use from mallinfo2 on glibc.
+ *   With counters set the hardware counters of the calling thread are
+ *   read at the same points, see perfctr.c.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "profile.h"
+#include "affinity.h"
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define PROFILE_HEAP
+#endif
+
+static const char *names[PROFILE_PHASES] = {
+  "read", "parse", "reorder", "canon", "csc", "prune", "stats", "prepare", "kernel", "spmv", "c3"
+};
+
+double profile_now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + (double)t.tv_nsec / 1000000000;
+}
+
+/* Bytes handed out by malloc and not yet freed, 0 where unknown */
+static int64_t heap_in_use(void) {
+#ifdef PROFILE_HEAP
+  struct mallinfo2 info = mallinfo2();
+  return (int64_t)(info.uordblks + info.hblkhd);
+#else
+  return 0;
+#endif
+}
+
+static uint64_t peak_rss(void) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+const char *profile_phase_name(int phase) {
+  return (phase >= 0 && phase < PROFILE_PHASES) ? names[phase] : "unknown";
+}
+
+void profile_begin(profile *p) {
+  if (p == NULL) return;
+  p->heap = heap_in_use();
+  if (p->counters) perfctr_read(&p->mark_events);
+  p->mark = profile_now();
+}
+
+void profile_end(profile *p, int const phase) {
+  if (p == NULL) return;
+  double now = profile_now();
+  int64_t heap = heap_in_use();
+  p->seconds[phase] += now - p->mark;
+  p->bytes[phase] += heap - p->heap;
+  p->peak_rss[phase] = peak_rss();
+  p->heap = heap;
+  if (p->counters) {
+    perfctr_sample events;
+    perfctr_read(&events);
+    perfctr_add(&p->events[phase], &events, &p->mark_events);
+    p->mark_events = events;
+  }
+  if (p->trace) trace_record(&p->trace->main, p->mark, now, 0, 0, names[phase]);
+  p->mark = profile_now();
+}
+
+/* Room for the per worker timers of the next kernel */
+void profile_workers(profile *p, int const workers) {
+  if (p == NULL) return;
+  free(p->worker_seconds);
+  free(p->worker_items);
+  free(p->worker_cpu);
+  free(p->worker_bytes);
+  free(p->worker_events);
+  free(p->worker_work);
+  p->workers = workers;
+  p->worker_seconds = calloc(workers, sizeof(double));
+  p->worker_items = calloc(workers, sizeof(uint64_t));
+  p->worker_cpu = calloc(workers, sizeof(int));
+  p->worker_bytes = calloc(workers, sizeof(uint64_t));
+  p->worker_events = calloc(workers, sizeof(perfctr_sample));
+  p->worker_work = calloc(workers, sizeof(work_counters));
+  if (p->trace) trace_workers(p->trace, workers);
+}
+
+/* Called by worker from inside the parallel region, every worker owns its slot */
+void profile_worker(profile *p, int const worker, double const seconds, uint32_t const items,
+                    int const cpu, uint64_t const bytes,
+                    perfctr_sample const *end, perfctr_sample const *start) {
+  p->worker_seconds[worker] += seconds;
+  p->worker_items[worker] += items;
+  p->worker_cpu[worker] = cpu;
+  p->worker_bytes[worker] += bytes;
+  if (p->counters) perfctr_add(&p->worker_events[worker], end, start);
+  work_take(&p->worker_work[worker]);
+}
+
+/* The work counters of all workers merged */
+void profile_work(profile const *p, work_counters *total) {
+  memset(total, 0, sizeof(work_counters));
+  for (int w = 0; w < p->workers && p->worker_work; w++) work_merge(total, &p->worker_work[w]);
+}
+
+void profile_free(profile *p) {
+  if (p == NULL) return;
+  free(p->worker_seconds);
+  free(p->worker_items);
+  free(p->worker_cpu);
+  free(p->worker_bytes);
+  free(p->worker_events);
+  free(p->worker_work);
+  p->worker_seconds = NULL;
+  p->worker_items = NULL;
+  p->worker_cpu = NULL;
+  p->worker_bytes = NULL;
+  p->worker_events = NULL;
+  p->worker_work = NULL;
+}
+
+/* The kernel counters are the sum over the workers, whose bodies are the whole kernel */
+static perfctr_sample phase_events(profile const *p, int const phase) {
+  perfctr_sample events = p->events[phase];
+  if (phase == PROFILE_KERNEL && p->worker_events) {
+    memset(&events, 0, sizeof(events));
+    for (int w = 0; w < p->workers; w++) perfctr_add(&events, &p->worker_events[w], NULL);
+  }
+  return events;
+}
+
+static void print_counters(profile const *p) {
+  if (!perfctr_available()) {
+    printf("\nHardware counters: not permitted here (perf_event_paranoid or no PMU), timings only");
+    return;
+  }
+  printf("\nHardware counters:");
+  for (int s = 0; s < PROFILE_PHASES; s++) {
+    if (p->seconds[s] == 0) continue;
+    perfctr_sample events = phase_events(p, s);
+    perfctr_print(names[s], &events, s == PROFILE_KERNEL ? p->intersections : 0);
+  }
+  for (int w = 0; w < p->workers && p->worker_events; w++) {
+    char label[32];
+    snprintf(label, sizeof(label), "worker %d", w);
+    perfctr_print(label, &p->worker_events[w], 0);
+  }
+}
+
+void profile_print(profile const *p) {
+  double total = 0;
+  for (int s = 0; s < PROFILE_PHASES; s++) total += p->seconds[s];
+
+  printf("\n%-8s %12s %7s %14s %12s", "Phase", "Seconds", "Share", "Heap bytes", "Peak RSS KB");
+  for (int s = 0; s < PROFILE_PHASES; s++) {
+    printf("\n%-8s %12.6f %6.1f%% %14lld %12llu", names[s], p->seconds[s],
+           total > 0 ? 100 * p->seconds[s] / total : 0.0,
+           (long long)p->bytes[s], (unsigned long long)p->peak_rss[s]);
+  }
+  printf("\n%-8s %12.6f", "total", total);
+  for (int w = 0; w < p->workers && p->worker_seconds; w++) {
+    printf("\nWorker %d: %f s in %llu items", w, p->worker_seconds[w],
+           (unsigned long long)p->worker_items[w]);
+  }
+  if (p->worker_seconds) affinity_report(p->worker_cpu, p->worker_bytes, p->worker_seconds, p->workers, "\n");
+  if (p->counters) print_counters(p);
+  if (work_enabled()) {
+    work_counters total;
+    profile_work(p, &total);
+    work_print(&total);
+  }
+  printf("\n");
+}
+
+void profile_write_json(profile const *p, FILE *f) {
+  fprintf(f, "{\n  \"phases\": [");
+  for (int s = 0; s < PROFILE_PHASES; s++) {
+    fprintf(f, "%s\n    { \"phase\": \"%s\", \"seconds\": %.9f, \"heap_bytes\": %lld, \"peak_rss_kb\": %llu",
+            s ? "," : "", names[s], p->seconds[s], (long long)p->bytes[s], (unsigned long long)p->peak_rss[s]);
+    if (p->counters) {
+      perfctr_sample events = phase_events(p, s);
+      perfctr_write_json(&events, f);
+    }
+    fprintf(f, " }");
+  }
+  fprintf(f, "\n  ],\n  \"workers\": [");
+  for (int w = 0; w < p->workers && p->worker_seconds; w++) {
+    fprintf(f, "%s\n    { \"worker\": %d, \"seconds\": %.9f, \"items\": %llu, \"cpu\": %d, \"modeled_bytes\": %llu",
+            w ? "," : "", w, p->worker_seconds[w], (unsigned long long)p->worker_items[w],
+            p->worker_cpu[w], (unsigned long long)p->worker_bytes[w]);
+    if (p->counters) perfctr_write_json(&p->worker_events[w], f);
+    fprintf(f, " }");
+  }
+  fprintf(f, "\n  ],\n  \"intersections\": %llu", (unsigned long long)p->intersections);
+  if (work_enabled()) {
+    work_counters total;
+    profile_work(p, &total);
+    fprintf(f, ",\n  \"work\": ");
+    work_write_json(&total, f);
+  }
+  fprintf(f, "\n}");
+}
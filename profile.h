@@ -0,0 +1,67 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "perfctr.h"
+#include "work.h"
+#include "trace.h"
+
+/* Phases of a count, in the order they run */
+#define PROFILE_READ     0   /* open, banner and size line */
+#define PROFILE_PARSE    1   /* fscanf of the entries, or the generator */
+#define PROFILE_REORDER  2   /* relabelling and column sort */
+#define PROFILE_CANON    3   /* orientation, sort and repeats of the COO */
+#define PROFILE_CSC      4   /* coo2csc_symmetric, coo2csc or lowertri_build */
+#define PROFILE_PRUNE    5   /* peeling to the 2-core and compaction */
+#define PROFILE_STATS    6   /* degree statistics and engine choice of auto */
+#define PROFILE_PREPARE  7   /* workspaces, tiles, task plan */
+#define PROFILE_KERNEL   8   /* the engine */
+#define PROFILE_SPMV     9   /* C times ones, or the sum of the c3 copies */
+#define PROFILE_C3       10  /* c3 halving, triangle sum and scatter back */
+#define PROFILE_PHASES   11
+
+typedef struct {
+  double    seconds[PROFILE_PHASES];   /*!< Wall time of every phase */
+  int64_t   bytes[PROFILE_PHASES];     /*!< Heap growth over every phase */
+  uint64_t  peak_rss[PROFILE_PHASES];  /*!< Peak resident set after the phase (KB) */
+  int       workers;                   /*!< Workers of the kernel */
+  double   *worker_seconds;            /*!< Kernel time spent in bodies, per worker */
+  uint64_t *worker_items;              /*!< Work items done, per worker */
+  int      *worker_cpu;                /*!< Core a worker last ran a body on */
+  uint64_t *worker_bytes;              /*!< Modeled traffic of the bodies, per worker, see affinity_column_bytes */
+  double    mark;                      /*!< Start of the running phase */
+  int64_t   heap;                      /*!< Heap in use at the mark */
+  int       counters;                  /*!< Also read the hardware counters */
+  perfctr_sample  events[PROFILE_PHASES]; /*!< Counters of the calling thread per phase */
+  perfctr_sample *worker_events;       /*!< Counters inside the bodies, per worker */
+  perfctr_sample  mark_events;         /*!< Counters at the mark */
+  uint64_t  intersections;             /*!< Mask nonzeros of the kernel, one intersection each */
+  work_counters  *worker_work;         /*!< Work counters of the bodies, per worker (make WORK=1) */
+  trace_log *trace;                    /*!< Timeline of phases and chunks when not NULL, owned by the caller */
+} profile;
+
+double profile_now(void);
+
+const char *profile_phase_name(int phase);
+
+void profile_begin(profile *p);
+
+void profile_end(profile *p, int const phase);
+
+void profile_workers(profile *p, int const workers);
+
+void profile_worker(profile *p, int const worker, double const seconds, uint32_t const items,
+                    int const cpu, uint64_t const bytes,
+                    perfctr_sample const *end, perfctr_sample const *start);
+
+void profile_work(profile const *p, work_counters *total);
+
+void profile_free(profile *p);
+
+void profile_print(profile const *p);
+
+void profile_write_json(profile const *p, FILE *f);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef PRUNE_H
+#define PRUNE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+typedef struct {
+  uint32_t  vertices;       /*!< Vertices before */
+  uint32_t  edges;          /*!< Edges before, nonzeros / 2 */
+  uint32_t  kept_vertices;  /*!< Vertices of the 2-core */
+  uint32_t  kept_edges;     /*!< Edges of the 2-core */
+  uint32_t  leaves;         /*!< Vertices below degree 2 before any peeling */
+  double    seconds;        /*!< Peeling and compaction */
+} prune_stats;
+
+uint32_t *prune_2core(
+  uint32_t       * const row,   /*!< Full symmetric CSC row indices, compacted in place */
+  uint32_t       * const col,   /*!< CSC column start indices (n+1), compacted in place */
+  uint32_t       * const n,     /*!< Number of columns, in and out */
+  prune_stats    * const s      /*!< Reduction, out */
+);
+
+void prune_print(prune_stats const *s);
+
+#endif
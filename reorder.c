@@ -0,0 +1,396 @@
+/**
+ *   \file reorder.c
+ *   \brief Cache-friendly vertex relabeling of the COO before coo2csc
+ *
+ *   The counting kernels follow cscRow into the adjacency of every
+ *   neighbour, so ids that are close in the graph should also be close in
+ *   memory. Each strategy produces a permutation, relabels the COO in
+ *   place and hands the permutation back so that per vertex results can
+ *   be returned under the original ids.
+ *
+ *   The adjacency, the degree order and the relabeling run in parallel,
+ *   RCM and Gorder place one vertex after the other and stay sequential.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "reorder.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define REORDER_NONE_ID UINT32_MAX
+
+/* Full symmetric adjacency used while computing an order */
+typedef struct {
+  uint32_t *col;      /*!< Start of every adjacency list (n+1) */
+  uint32_t *row;      /*!< Neighbours */
+  uint32_t  n;
+} adjacency;
+
+/*****************************************************************************/
+/*                                  helpers                                  */
+/*****************************************************************************/
+
+int reorder_parse(const char *name) {
+  if (name == NULL || strcmp(name, "none") == 0) return REORDER_NONE;
+  if (strcmp(name, "degree") == 0) return REORDER_DEGREE;
+  if (strcmp(name, "rcm") == 0)    return REORDER_RCM;
+  if (strcmp(name, "gorder") == 0) return REORDER_GORDER;
+  return -1;
+}
+
+const char *reorder_name(int strategy) {
+  switch (strategy) {
+    case REORDER_DEGREE: return "degree";
+    case REORDER_RCM:    return "rcm";
+    case REORDER_GORDER: return "gorder";
+    default:             return "none";
+  }
+}
+
+/* Lists filled in parallel, then sorted so the result does not depend on the threads */
+static void adjacency_build(
+  adjacency            * adj,
+  uint32_t const * const row_coo,
+  uint32_t const * const col_coo,
+  uint32_t const         nz,
+  uint32_t const         n
+) {
+  adj->n   = n;
+  adj->col = calloc(n + 1, sizeof(uint32_t));
+
+  #pragma omp parallel for schedule(static)
+  for (uint32_t l = 0; l < nz; l++) {
+    if (row_coo[l] == col_coo[l]) continue;
+    #pragma omp atomic
+    adj->col[row_coo[l] + 1]++;
+    #pragma omp atomic
+    adj->col[col_coo[l] + 1]++;
+  }
+  for (uint32_t i = 0; i < n; i++)
+    adj->col[i+1] += adj->col[i];
+
+  adj->row = malloc(((size_t)adj->col[n] + 1) * sizeof(uint32_t));
+  uint32_t *fill = malloc(((size_t)n + 1) * sizeof(uint32_t));
+  memcpy(fill, adj->col, n * sizeof(uint32_t));
+  #pragma omp parallel for schedule(static)
+  for (uint32_t l = 0; l < nz; l++) {
+    uint32_t a = row_coo[l], b = col_coo[l], p, q;
+    if (a == b) continue;
+    #pragma omp atomic capture
+    p = fill[b]++;
+    #pragma omp atomic capture
+    q = fill[a]++;
+    adj->row[p] = a;
+    adj->row[q] = b;
+  }
+  free(fill);
+  reorder_sort_columns(adj->row, adj->col, n);
+}
+
+static void adjacency_free(adjacency *adj) {
+  free(adj->col);
+  free(adj->row);
+}
+
+#define DEGREE(adj, v) ((adj)->col[(v)+1] - (adj)->col[(v)])
+
+static int compare_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static int compare_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+/*****************************************************************************/
+/*                                strategies                                 */
+/*****************************************************************************/
+
+/*
+ *  Counting sort by degree, ties keep the original order. Every part
+ *  counts a block of vertices and places them after the same degree in
+ *  the blocks before it, which keeps the sort stable.
+ */
+static void order_degree(adjacency const *adj, uint32_t *perm) {
+  uint32_t n = adj->n, max_degree = 0;
+  int parts = 1;
+
+#ifdef _OPENMP
+  parts = omp_get_max_threads();
+#endif
+  #pragma omp parallel for schedule(static) reduction(max:max_degree)
+  for (uint32_t v = 0; v < n; v++)
+    if (DEGREE(adj, v) > max_degree) max_degree = DEGREE(adj, v);
+
+  size_t width = (size_t)max_degree + 1;
+  uint32_t *bucket = calloc(parts * width, sizeof(uint32_t));
+  #pragma omp parallel for num_threads(parts)
+  for (int t = 0; t < parts; t++)
+    for (uint32_t v = (uint64_t)n * t / parts; v < (uint64_t)n * (t + 1) / parts; v++)
+      bucket[t * width + DEGREE(adj, v)]++;
+
+  /* Exclusive prefix over degree first, part second */
+  uint32_t sum = 0;
+  for (size_t d = 0; d < width; d++)
+    for (int t = 0; t < parts; t++) {
+      uint32_t count = bucket[t * width + d];
+      bucket[t * width + d] = sum;
+      sum += count;
+    }
+
+  #pragma omp parallel for num_threads(parts)
+  for (int t = 0; t < parts; t++)
+    for (uint32_t v = (uint64_t)n * t / parts; v < (uint64_t)n * (t + 1) / parts; v++)
+      perm[bucket[t * width + DEGREE(adj, v)]++] = v;
+
+  free(bucket);
+}
+
+/*
+ *  Breadth first search from the lowest degree vertex of every component,
+ *  neighbours enqueued by ascending degree, and the final order reversed.
+ */
+static void order_rcm(adjacency const *adj, uint32_t *perm) {
+  uint32_t n = adj->n;
+  uint32_t *by_degree = malloc(n * sizeof(uint32_t));
+  uint8_t  *visited = calloc(n, sizeof(uint8_t));
+  uint64_t *keys = NULL;
+  uint32_t  keys_size = 0;
+  uint32_t  head = 0, tail = 0;
+
+  order_degree(adj, by_degree);
+
+  for (uint32_t s = 0; s < n; s++) {
+    uint32_t root = by_degree[s];
+    if (visited[root]) continue;
+
+    visited[root] = 1;
+    perm[tail++] = root;
+
+    while (head < tail) {
+      uint32_t u = perm[head++];
+      uint32_t count = 0;
+
+      if (DEGREE(adj, u) > keys_size) {
+        keys_size = DEGREE(adj, u);
+        keys = realloc(keys, keys_size * sizeof(uint64_t));
+      }
+      for (uint32_t p = adj->col[u]; p < adj->col[u+1]; p++) {
+        uint32_t v = adj->row[p];
+        if (visited[v]) continue;
+        visited[v] = 1;
+        keys[count++] = ((uint64_t)DEGREE(adj, v) << 32) | v;
+      }
+      qsort(keys, count, sizeof(uint64_t), compare_u64);
+      for (uint32_t c = 0; c < count; c++)
+        perm[tail++] = (uint32_t)keys[c];
+    }
+  }
+
+  for (uint32_t i = 0; i < n / 2; i++) {
+    uint32_t temp = perm[i];
+    perm[i] = perm[n - 1 - i];
+    perm[n - 1 - i] = temp;
+  }
+
+  free(keys);
+  free(visited);
+  free(by_degree);
+}
+
+/* Bucket priority queue whose keys only ever move by one (Gorder's unit heap) */
+typedef struct {
+  uint32_t *key, *prev, *next, *head;
+  uint32_t  head_size, top;
+  uint8_t  *placed;
+} unit_heap;
+
+static void heap_unlink(unit_heap *h, uint32_t v) {
+  if (h->prev[v] != REORDER_NONE_ID) h->next[h->prev[v]] = h->next[v];
+  else                               h->head[h->key[v]]  = h->next[v];
+  if (h->next[v] != REORDER_NONE_ID) h->prev[h->next[v]] = h->prev[v];
+}
+
+static void heap_link(unit_heap *h, uint32_t v) {
+  uint32_t k = h->key[v];
+  if (k >= h->head_size) {
+    uint32_t size = h->head_size;
+    while (size <= k) size *= 2;
+    h->head = realloc(h->head, size * sizeof(uint32_t));
+    for (uint32_t i = h->head_size; i < size; i++) h->head[i] = REORDER_NONE_ID;
+    h->head_size = size;
+  }
+  h->prev[v] = REORDER_NONE_ID;
+  h->next[v] = h->head[k];
+  if (h->head[k] != REORDER_NONE_ID) h->prev[h->head[k]] = v;
+  h->head[k] = v;
+  if (k > h->top) h->top = k;
+}
+
+static void heap_add(unit_heap *h, uint32_t v, int delta) {
+  if (h->placed[v]) return;
+  heap_unlink(h, v);
+  h->key[v] += delta;
+  heap_link(h, v);
+}
+
+static uint32_t heap_pop(unit_heap *h) {
+  while (h->top > 0 && h->head[h->top] == REORDER_NONE_ID) h->top--;
+  uint32_t v = h->head[h->top];
+  heap_unlink(h, v);
+  h->placed[v] = 1;
+  return v;
+}
+
+/*
+ *  Credit (or withdraw, delta = -1) the score a placed vertex gives its
+ *  unplaced neighbours and siblings. Siblings of hubs are skipped, as in
+ *  Gorder, because they would cost O(deg^2) while carrying little locality.
+ */
+static void gorder_score(unit_heap *h, adjacency const *adj, uint32_t v, uint32_t hub, int delta) {
+  for (uint32_t p = adj->col[v]; p < adj->col[v+1]; p++) {
+    uint32_t u = adj->row[p];
+    heap_add(h, u, delta);
+    if (DEGREE(adj, u) > hub) continue;
+    for (uint32_t q = adj->col[u]; q < adj->col[u+1]; q++)
+      if (adj->row[q] != v) heap_add(h, adj->row[q], delta);
+  }
+}
+
+/*
+ *  Greedy Gorder: the next vertex is the unplaced one with the most
+ *  neighbour and sibling relations to the last REORDER_GORDER_WINDOW
+ *  vertices. Ties and empty windows fall back to the highest degree.
+ */
+static void order_gorder(adjacency const *adj, uint32_t *perm) {
+  uint32_t n = adj->n;
+  uint32_t hub = 16;
+  while (hub * hub < n) hub++;
+
+  unit_heap h;
+  h.key       = calloc(n, sizeof(uint32_t));
+  h.prev      = malloc(n * sizeof(uint32_t));
+  h.next      = malloc(n * sizeof(uint32_t));
+  h.placed    = calloc(n, sizeof(uint8_t));
+  h.head_size = 64;
+  h.head      = malloc(h.head_size * sizeof(uint32_t));
+  h.top       = 0;
+  for (uint32_t i = 0; i < h.head_size; i++) h.head[i] = REORDER_NONE_ID;
+
+  /* Ascending degree, so the highest degree vertex ends at the bucket head */
+  uint32_t *by_degree = malloc(n * sizeof(uint32_t));
+  order_degree(adj, by_degree);
+  for (uint32_t i = 0; i < n; i++) heap_link(&h, by_degree[i]);
+  free(by_degree);
+
+  for (uint32_t i = 0; i < n; i++) {
+    perm[i] = heap_pop(&h);
+    gorder_score(&h, adj, perm[i], hub, 1);
+    if (i >= REORDER_GORDER_WINDOW)
+      gorder_score(&h, adj, perm[i - REORDER_GORDER_WINDOW], hub, -1);
+  }
+
+  free(h.key);
+  free(h.prev);
+  free(h.next);
+  free(h.placed);
+  free(h.head);
+}
+
+/*****************************************************************************/
+/*                             routine definition                            */
+/*****************************************************************************/
+
+/**
+ *  \brief Compute an order and relabel the COO in place
+ *
+ *  The COO should be canonical, see canon.h, so that the order is
+ *  computed on distinct edges. Relabeling flips entries across the
+ *  diagonal and scatters them, so run canon_coo again afterwards.
+ *  Returns perm with perm[new id] = old id, or NULL for REORDER_NONE.
+ */
+uint32_t *reorder_coo(
+  int const              strategy,
+  uint32_t       * const row_coo,
+  uint32_t       * const col_coo,
+  uint32_t const         nz,
+  uint32_t const         n
+) {
+  if (strategy == REORDER_NONE || nz == 0) return NULL;
+
+  adjacency adj;
+  uint32_t *perm = malloc(n * sizeof(uint32_t));
+  uint32_t *iperm = malloc(n * sizeof(uint32_t));
+
+  adjacency_build(&adj, row_coo, col_coo, nz, n);
+  switch (strategy) {
+    case REORDER_RCM:    order_rcm(&adj, perm);    break;
+    case REORDER_GORDER: order_gorder(&adj, perm); break;
+    default:             order_degree(&adj, perm); break;
+  }
+  adjacency_free(&adj);
+
+  #pragma omp parallel for
+  for (uint32_t i = 0; i < n; i++) iperm[perm[i]] = i;
+
+  #pragma omp parallel for
+  for (uint32_t l = 0; l < nz; l++) {
+    row_coo[l] = iperm[row_coo[l]];
+    col_coo[l] = iperm[col_coo[l]];
+  }
+
+  free(iperm);
+  return perm;
+}
+
+/**
+ *  \brief Sort the row indices of every column
+ *
+ *  Short columns by insertion, long ones by qsort, one column per
+ *  iteration of a parallel loop.
+ */
+void reorder_sort_columns(
+  uint32_t       * const row,
+  uint32_t const * const col,
+  uint32_t const         n
+) {
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (uint32_t j = 0; j < n; j++) {
+    uint32_t first = col[j], last = col[j+1];
+    if (last - first > 32) {
+      qsort(row + first, last - first, sizeof(uint32_t), compare_u32);
+      continue;
+    }
+    for (uint32_t p = first + 1; p < last; p++) {
+      uint32_t v = row[p], q = p;
+      while (q > first && row[q-1] > v) {
+        row[q] = row[q-1];
+        q--;
+      }
+      row[q] = v;
+    }
+  }
+}
+
+/**
+ *  \brief Move per vertex results from the new ids back to the original ones
+ */
+void reorder_scatter_back(
+  int            * const values,
+  uint32_t const * const perm,
+  uint32_t const         n
+) {
+  int *temp = malloc(n * sizeof(int));
+  memcpy(temp, values, n * sizeof(int));
+
+  #pragma omp parallel for
+  for (uint32_t i = 0; i < n; i++) values[perm[i]] = temp[i];
+
+  free(temp);
+}
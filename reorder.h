@@ -0,0 +1,41 @@
+#ifndef REORDER_H
+#define REORDER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Vertex reordering strategies, applied to the canonical COO before coo2csc */
+#define REORDER_NONE    0
+#define REORDER_DEGREE  1   /* ascending degree, hubs get the largest ids */
+#define REORDER_RCM     2   /* reverse Cuthill-McKee, small bandwidth */
+#define REORDER_GORDER  3   /* greedy window locality, Gorder style */
+
+/* Number of previously placed vertices a candidate is scored against */
+#define REORDER_GORDER_WINDOW 5
+
+int reorder_parse(const char *name);
+
+const char *reorder_name(int strategy);
+
+uint32_t *reorder_coo(
+  int const              strategy,  /*!< One of the REORDER_* strategies */
+  uint32_t       * const row_coo,   /*!< COO row indices, relabeled in place */
+  uint32_t       * const col_coo,   /*!< COO column indices, relabeled in place */
+  uint32_t const         nz,        /*!< Number of COO entries (one triangle) */
+  uint32_t const         n          /*!< Number of rows/columns */
+);
+
+void reorder_sort_columns(
+  uint32_t       * const row,       /*!< CSC row indices, sorted in place */
+  uint32_t const * const col,       /*!< CSC column start indices */
+  uint32_t const         n          /*!< Number of columns */
+);
+
+void reorder_scatter_back(
+  int            * const values,    /*!< Per vertex values, new ids in, old ids out */
+  uint32_t const * const perm,      /*!< perm[new id] = old id */
+  uint32_t const         n          /*!< Number of vertices */
+);
+
+#endif
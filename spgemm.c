@@ -0,0 +1,336 @@
+/**
+ *   \file spgemm.c
+ *   \brief Masked SpGEMM engines that compute C = A.*(A*A) on a symmetric CSC
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "spgemm.h"
+#include "work.h"
+
+#define SPGEMM_EMPTY UINT32_MAX
+
+/*****************************************************************************/
+/*                             engine selection                              */
+/*****************************************************************************/
+
+int spgemm_parse_engine(const char *name) {
+  if (name == NULL || strcmp(name, "auto") == 0) return SPGEMM_AUTO;
+  if (strcmp(name, "dot") == 0)       return SPGEMM_DOT;
+  if (strcmp(name, "gustavson") == 0) return SPGEMM_GUSTAVSON;
+  if (strcmp(name, "hash") == 0)      return SPGEMM_HASH;
+  if (strcmp(name, "lower") == 0)     return SPGEMM_LOWER;
+  if (strcmp(name, "tiled") == 0)     return SPGEMM_TILED;
+  if (strcmp(name, "tasks") == 0)     return SPGEMM_TASKS;
+  if (strcmp(name, "edges") == 0)     return SPGEMM_EDGES;
+  return -1;
+}
+
+const char *spgemm_engine_name(int engine) {
+  switch (engine) {
+    case SPGEMM_DOT:       return "dot";
+    case SPGEMM_GUSTAVSON: return "gustavson";
+    case SPGEMM_HASH:      return "hash";
+    case SPGEMM_LOWER:     return "lower";
+    case SPGEMM_TILED:     return "tiled";
+    case SPGEMM_TASKS:     return "tasks";
+    case SPGEMM_EDGES:     return "edges";
+    default:               return "auto";
+  }
+}
+
+/**
+ *  \brief Pick an engine from the density of the matrix
+ *
+ *  Sparse graphs have short lists, so merging two of them per nonzero is
+ *  cheap. Once the average degree grows the column-wise engines pay off,
+ *  because each column's mask is scattered once and reused for all of its
+ *  neighbours. The dense marker needs n slots per worker, so for huge n we
+ *  fall back to the hash accumulator.
+ */
+int spgemm_choose_engine(
+  uint32_t const         n,
+  uint32_t const         nnz,
+  int const              workers
+) {
+  if (n == 0 || nnz / n < SPGEMM_GUSTAVSON_MIN_DEGREE)
+    return SPGEMM_DOT;
+
+  if ((uint64_t)n * sizeof(uint32_t) * (workers > 0 ? workers : 1) <= SPGEMM_DENSE_BUDGET)
+    return SPGEMM_GUSTAVSON;
+
+  return SPGEMM_HASH;
+}
+
+/*****************************************************************************/
+/*                                workspaces                                 */
+/*****************************************************************************/
+
+spgemm_workspace *spgemm_workspace_create(
+  int const              engine,
+  uint32_t const * const cscColumn,
+  uint32_t const         n
+) {
+  spgemm_workspace *ws = calloc(1, sizeof(spgemm_workspace));
+
+  if (engine == SPGEMM_GUSTAVSON) {
+    ws->marker = malloc(n * sizeof(uint32_t));
+    for (uint32_t i = 0; i < n; i++) ws->marker[i] = SPGEMM_EMPTY;
+  }
+  else if (engine == SPGEMM_HASH) {
+    uint32_t max_degree = 0;
+    for (uint32_t i = 0; i < n; i++)
+      if (cscColumn[i+1] - cscColumn[i] > max_degree)
+        max_degree = cscColumn[i+1] - cscColumn[i];
+
+    /* Keep the load factor at or below one half */
+    uint32_t size = 16;
+    while (size < 2 * max_degree) size <<= 1;
+    ws->mask = size - 1;
+    ws->keys = malloc(size * sizeof(uint32_t));
+    ws->vals = malloc(size * sizeof(uint32_t));
+    for (uint32_t i = 0; i < size; i++) ws->keys[i] = SPGEMM_EMPTY;
+  }
+
+  return ws;
+}
+
+void spgemm_workspace_free(spgemm_workspace *ws) {
+  if (ws == NULL) return;
+  free(ws->marker);
+  free(ws->keys);
+  free(ws->vals);
+  free(ws);
+}
+
+/*****************************************************************************/
+/*                                  engines                                  */
+/*****************************************************************************/
+
+/**
+ *  \brief Number of common elements of two sorted lists
+ */
+uint32_t spgemm_intersect_lists(
+  uint32_t const * const a,
+  uint32_t const         na,
+  uint32_t const * const b,
+  uint32_t const         nb
+) {
+  uint32_t k_pointer = 0, l_pointer = 0;
+  uint32_t value = 0;
+
+  while (k_pointer != na && l_pointer != nb) {
+    if (a[k_pointer] == b[l_pointer]) {
+      value++;
+      k_pointer++;
+      l_pointer++;
+    }
+    else if (a[k_pointer] > b[l_pointer]) {
+      l_pointer++;
+    }
+    else {
+      k_pointer++;
+    }
+  }
+  WORK_ADD(intersections, 1);
+  WORK_ADD(compared, k_pointer + l_pointer);
+  WORK_ADD(hits, value);
+  WORK_SIZE(na + nb);
+  return value;
+}
+
+/**
+ *  \brief Number of common rows of the sorted columns i and j
+ */
+uint32_t spgemm_intersect(
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         i,
+  uint32_t const         j
+) {
+  return spgemm_intersect_lists(cscRow + cscColumn[i], cscColumn[i+1] - cscColumn[i],
+                                cscRow + cscColumn[j], cscColumn[j+1] - cscColumn[j]);
+}
+
+/* C(i,j) = |A(:,i) .* A(:,j)| for every nonzero (i,j) of the column range */
+static void dot_range(
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         start,
+  uint32_t const         end,
+  uint32_t       * const c_values
+) {
+  for (uint32_t j = start; j < end; j++)
+    for (uint32_t p = cscColumn[j]; p < cscColumn[j+1]; p++)
+      c_values[p] = spgemm_intersect(cscRow, cscColumn, cscRow[p], j);
+}
+
+/**
+ *  \brief Column holding nonzero p: the last j with cscColumn[j] <= p
+ *
+ *  Empty columns share their start with the next one, the search skips
+ *  them by taking the last match.
+ */
+uint32_t spgemm_edge_column(
+  uint32_t const * const cscColumn,
+  uint32_t const         n,
+  uint32_t const         p
+) {
+  uint32_t lo = 0, hi = n;
+
+  while (lo + 1 < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (cscColumn[mid] <= p) lo = mid;
+    else                     hi = mid;
+  }
+  return lo;
+}
+
+/**
+ *  \brief Edge-centric dot product over the nonzeros [first, last)
+ *
+ *  The column is found once by binary search and then followed forward,
+ *  so a block costs the same number of intersections whatever the degrees
+ *  of the columns it crosses.
+ */
+void spgemm_dot_edges(
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         n,
+  uint32_t const         first,
+  uint32_t const         last,
+  uint32_t       * const c_values
+) {
+  if (first >= last) return;
+  uint32_t j = spgemm_edge_column(cscColumn, n, first);
+
+  for (uint32_t p = first; p < last; p++) {
+    while (p >= cscColumn[j+1]) j++;
+    c_values[p] = spgemm_intersect(cscRow, cscColumn, cscRow[p], j);
+  }
+}
+
+/*
+ *  Gustavson form: scatter the mask A(:,j) into the marker and expand
+ *  A(:,k) for every k in A(:,j). The marker stores the position of row i
+ *  inside cscRow, and since the column ranges are disjoint a stale entry
+ *  left from another column can never fall inside [cscColumn[j], cscColumn[j+1]),
+ *  so the marker never has to be cleared.
+ */
+static void gustavson_range(
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         start,
+  uint32_t const         end,
+  uint32_t       * const c_values,
+  uint32_t       * const marker
+) {
+  for (uint32_t j = start; j < end; j++) {
+    uint32_t first = cscColumn[j], last = cscColumn[j+1];
+
+    for (uint32_t p = first; p < last; p++) {
+      marker[cscRow[p]] = p;
+      c_values[p] = 0;
+    }
+
+    for (uint32_t p = first; p < last; p++) {
+      uint32_t k = cscRow[p];
+      for (uint32_t q = cscColumn[k]; q < cscColumn[k+1]; q++) {
+        uint32_t m = marker[cscRow[q]];
+        if (m >= first && m < last)
+          c_values[m]++;
+      }
+      WORK_ADD(wedges, cscColumn[k+1] - cscColumn[k]);
+      WORK_ADD(compared, cscColumn[k+1] - cscColumn[k]);
+      WORK_SIZE(cscColumn[k+1] - cscColumn[k]);
+    }
+#ifdef TRIANGLE_WORK
+    for (uint32_t p = first; p < last; p++) WORK_ADD(hits, c_values[p]);
+#endif
+  }
+}
+
+#define SPGEMM_HASH_SLOT(row, mask) (((row) * 2654435761u) & (mask))
+
+/* Same as gustavson_range with an open addressing table as the accumulator */
+static void hash_range(
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         start,
+  uint32_t const         end,
+  uint32_t       * const c_values,
+  spgemm_workspace     * ws
+) {
+  uint32_t * const keys = ws->keys;
+  uint32_t * const vals = ws->vals;
+  uint32_t const   mask = ws->mask;
+
+  for (uint32_t j = start; j < end; j++) {
+    uint32_t first = cscColumn[j], last = cscColumn[j+1];
+
+    for (uint32_t p = first; p < last; p++) {
+      uint32_t slot = SPGEMM_HASH_SLOT(cscRow[p], mask);
+      while (keys[slot] != SPGEMM_EMPTY) slot = (slot + 1) & mask;
+      keys[slot] = cscRow[p];
+      vals[slot] = p;
+      c_values[p] = 0;
+    }
+
+    for (uint32_t p = first; p < last; p++) {
+      uint32_t k = cscRow[p];
+      for (uint32_t q = cscColumn[k]; q < cscColumn[k+1]; q++) {
+        uint32_t row = cscRow[q];
+        uint32_t slot = SPGEMM_HASH_SLOT(row, mask);
+        while (keys[slot] != SPGEMM_EMPTY && keys[slot] != row)
+          slot = (slot + 1) & mask;
+        if (keys[slot] == row)
+          c_values[vals[slot]]++;
+      }
+      WORK_ADD(wedges, cscColumn[k+1] - cscColumn[k]);
+      WORK_ADD(compared, cscColumn[k+1] - cscColumn[k]);
+      WORK_SIZE(cscColumn[k+1] - cscColumn[k]);
+    }
+#ifdef TRIANGLE_WORK
+    for (uint32_t p = first; p < last; p++) WORK_ADD(hits, c_values[p]);
+#endif
+
+    /* Only the slots of this column were touched, clear just those */
+    for (uint32_t p = first; p < last; p++) {
+      uint32_t slot = SPGEMM_HASH_SLOT(cscRow[p], mask);
+      while (keys[slot] != SPGEMM_EMPTY) {
+        keys[slot] = SPGEMM_EMPTY;
+        slot = (slot + 1) & mask;
+      }
+    }
+  }
+}
+
+/**
+ *  \brief Masked product C = A.*(A*A) over the columns [start, end)
+ *
+ *  c_values shares the pattern of A, so c_values[p] is C(cscRow[p], j).
+ *  Every position of the range is written, zeros included.
+ */
+void spgemm_masked_range(
+  int const              engine,
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         start,
+  uint32_t const         end,
+  uint32_t       * const c_values,
+  spgemm_workspace     * ws
+) {
+  switch (engine) {
+    case SPGEMM_GUSTAVSON:
+      gustavson_range(cscRow, cscColumn, start, end, c_values, ws->marker);
+      break;
+    case SPGEMM_HASH:
+      hash_range(cscRow, cscColumn, start, end, c_values, ws);
+      break;
+    default:
+      dot_range(cscRow, cscColumn, start, end, c_values);
+      break;
+  }
+}
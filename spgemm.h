@@ -0,0 +1,90 @@
+#ifndef SPGEMM_H
+#define SPGEMM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Masked SpGEMM engines for C = A.*(A*A) */
+#define SPGEMM_AUTO       0
+#define SPGEMM_DOT        1   /* one sorted-list intersection per nonzero */
+#define SPGEMM_GUSTAVSON  2   /* column by column, dense marker accumulator */
+#define SPGEMM_HASH       3   /* column by column, hash accumulator */
+#define SPGEMM_LOWER      4   /* strictly lower half only, see lowertri.c */
+#define SPGEMM_TILED      5   /* dot product in cache-sized 2D tiles, see tiling.c */
+#define SPGEMM_TASKS      6   /* dot product over hub-split tasks, see tasks.c */
+#define SPGEMM_EDGES      7   /* dot product over equal blocks of nonzeros */
+
+/* Nonzeros per block of the edge-centric engine */
+#define SPGEMM_EDGE_BLOCK 2048
+
+/* Above this average degree the column-wise engines win over the dot product */
+#define SPGEMM_GUSTAVSON_MIN_DEGREE 16
+/* Upper bound for the dense markers of all workers together (bytes) */
+#define SPGEMM_DENSE_BUDGET (256u << 20)
+
+typedef struct {
+  uint32_t *marker;   /*!< Dense marker, one slot per row */
+  uint32_t *keys;     /*!< Hash table keys (row indices) */
+  uint32_t *vals;     /*!< Hash table values (position in cscRow) */
+  uint32_t  mask;     /*!< Hash table size - 1 */
+} spgemm_workspace;
+
+int spgemm_parse_engine(const char *name);
+
+const char *spgemm_engine_name(int engine);
+
+int spgemm_choose_engine(
+  uint32_t const         n,          /*!< Number of rows/columns */
+  uint32_t const         nnz,        /*!< Number of nonzero elements */
+  int const              workers     /*!< Number of workspaces needed */
+);
+
+spgemm_workspace *spgemm_workspace_create(
+  int const              engine,     /*!< Engine that will use the workspace */
+  uint32_t const * const cscColumn,  /*!< CSC column start indices */
+  uint32_t const         n           /*!< Number of rows/columns */
+);
+
+void spgemm_workspace_free(spgemm_workspace *ws);
+
+uint32_t spgemm_intersect_lists(
+  uint32_t const * const a,          /*!< Sorted list */
+  uint32_t const         na,
+  uint32_t const * const b,          /*!< Sorted list */
+  uint32_t const         nb
+);
+
+uint32_t spgemm_intersect(
+  uint32_t const * const cscRow,     /*!< CSC row indices, sorted per column */
+  uint32_t const * const cscColumn,  /*!< CSC column start indices */
+  uint32_t const         i,          /*!< First column */
+  uint32_t const         j           /*!< Second column */
+);
+
+void spgemm_masked_range(
+  int const              engine,     /*!< SPGEMM_DOT, SPGEMM_GUSTAVSON or SPGEMM_HASH */
+  uint32_t const * const cscRow,     /*!< CSC row indices, sorted per column */
+  uint32_t const * const cscColumn,  /*!< CSC column start indices */
+  uint32_t const         start,      /*!< First column to compute */
+  uint32_t const         end,        /*!< One past the last column */
+  uint32_t       * const c_values,   /*!< C values, same pattern as A */
+  spgemm_workspace     * ws          /*!< Per worker workspace (unused by dot) */
+);
+
+uint32_t spgemm_edge_column(
+  uint32_t const * const cscColumn,  /*!< CSC column start indices */
+  uint32_t const         n,          /*!< Number of columns */
+  uint32_t const         p           /*!< Position of a nonzero */
+);
+
+void spgemm_dot_edges(
+  uint32_t const * const cscRow,     /*!< CSC row indices, sorted per column */
+  uint32_t const * const cscColumn,  /*!< CSC column start indices */
+  uint32_t const         n,          /*!< Number of columns */
+  uint32_t const         first,      /*!< First nonzero to compute */
+  uint32_t const         last,       /*!< One past the last nonzero */
+  uint32_t       * const c_values    /*!< C values, same pattern as A */
+);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Power of two buckets of the degree histogram, bucket b holds [2^(b-1), 2^b) */
+#define STATS_BUCKETS 33
+
+typedef struct {
+  uint32_t  n;                  /*!< Vertices */
+  uint32_t  nnz;                /*!< Nonzeros of the full symmetric matrix */
+  uint32_t  min_degree;
+  uint32_t  max_degree;
+  uint32_t  isolated;           /*!< Vertices of degree 0 */
+  double    mean_degree;
+  double    stddev_degree;
+  double    skew;               /*!< max_degree / mean_degree, hubs when large */
+  double    density;            /*!< nnz / n^2 */
+  double    wedges;             /*!< Paths i-k-j, sum of d(d-1)/2 */
+  double    neighbour_degree;   /*!< Mean degree at the end of an edge, sum d^2 / sum d */
+  uint32_t  histogram[STATS_BUCKETS]; /*!< Vertices by degree */
+} graph_stats;
+
+void stats_compute(
+  uint32_t const * const cscColumn,  /*!< CSC column start indices of the full matrix (n+1) */
+  uint32_t const         n,          /*!< Number of columns */
+  graph_stats    * const s           /*!< Statistics, out */
+);
+
+void stats_print(graph_stats const *s);
+
+void stats_write_json(graph_stats const *s, FILE *f);
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ *   \file tasks.c
+ *   \brief Hub splitting task decomposition for the dot product engine
+ *
+ *   One task per column is badly skewed on power-law graphs: a hub column
+ *   costs as much as thousands of ordinary ones. The cost of nonzero (i,j)
+ *   in the dot form is about deg(i) + deg(j) merge steps, so the nonzeros
+ *   are cut into consecutive runs of about one grain of steps each. Light
+ *   columns end up batched into one task, hub columns are split into
+ *   several. Every nonzero is written by exactly one task, no locking.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "spgemm.h"
+#include "tasks.h"
+
+/**
+ *  \brief Cut the nonzeros into tasks of about one grain of work
+ *
+ *  The grain aims for TASKS_PER_WORKER tasks per worker but never drops
+ *  below TASKS_MIN_GRAIN or the average column cost, so light columns are
+ *  not chopped up for nothing.
+ */
+tasks_plan *tasks_build(
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         n,
+  int const              workers
+) {
+  tasks_plan *plan = malloc(sizeof(tasks_plan));
+  uint64_t total = 0;
+
+  // ----- degree statistics: total work and the grain
+  for (uint32_t j = 0; j < n; j++) {
+    uint32_t degree = cscColumn[j+1] - cscColumn[j];
+    for (uint32_t p = cscColumn[j]; p < cscColumn[j+1]; p++)
+      total += degree + cscColumn[cscRow[p] + 1] - cscColumn[cscRow[p]];
+  }
+  uint64_t grain = total / ((workers > 0 ? workers : 1) * TASKS_PER_WORKER);
+  if (n > 0 && grain < total / n) grain = total / n;
+  if (grain < TASKS_MIN_GRAIN)     grain = TASKS_MIN_GRAIN;
+  plan->grain = grain;
+
+  // ----- cut after the nonzero that fills the grain, so all tasks but the last hold a grain
+  uint32_t capacity = total / grain + 2;
+  plan->first  = malloc((capacity + 1) * sizeof(uint32_t));
+  plan->column = malloc((capacity + 1) * sizeof(uint32_t));
+  plan->tasks = 0;
+  plan->split = 0;
+
+  uint64_t work = 0;
+  int open = 0;
+  for (uint32_t j = 0; j < n; j++) {
+    uint32_t degree = cscColumn[j+1] - cscColumn[j];
+    int cut_inside = 0;
+    for (uint32_t p = cscColumn[j]; p < cscColumn[j+1]; p++) {
+      if (!open) {
+        plan->first[plan->tasks] = p;
+        plan->column[plan->tasks++] = j;
+        open = 1;
+      }
+      work += degree + cscColumn[cscRow[p] + 1] - cscColumn[cscRow[p]];
+      if (work >= grain) {
+        if (p + 1 < cscColumn[j+1]) cut_inside = 1;
+        work = 0;
+        open = 0;
+      }
+    }
+    plan->split += cut_inside;
+  }
+  plan->first[plan->tasks] = cscColumn[n];
+  plan->column[plan->tasks] = n;
+
+  return plan;
+}
+
+void tasks_free(tasks_plan *plan) {
+  if (plan == NULL) return;
+  free(plan->first);
+  free(plan->column);
+  free(plan);
+}
+
+/* C(i,j) = |A(:,i) .* A(:,j)| for every nonzero of the tasks */
+void tasks_dot(
+  tasks_plan     const * const plan,
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         first,
+  uint32_t const         last,
+  uint32_t       * const c_values
+) {
+  for (uint32_t t = first; t < last; t++) {
+    uint32_t j = plan->column[t];
+    for (uint32_t p = plan->first[t]; p < plan->first[t+1]; p++) {
+      while (p >= cscColumn[j+1]) j++;
+      c_values[p] = spgemm_intersect(cscRow, cscColumn, cscRow[p], j);
+    }
+  }
+}
@@ -0,0 +1,39 @@
+#ifndef TASKS_H
+#define TASKS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Tasks per worker the grain aims for, enough slack for stealing */
+#define TASKS_PER_WORKER 8
+/* Smallest grain (merge steps), below it task overhead dominates */
+#define TASKS_MIN_GRAIN  4096
+
+typedef struct {
+  uint32_t  tasks;       /*!< Number of tasks */
+  uint64_t  grain;       /*!< Merge steps per task */
+  uint32_t  split;       /*!< Columns cut into several tasks */
+  uint32_t *first;       /*!< First nonzero of every task (tasks+1) */
+  uint32_t *column;      /*!< Column holding the first nonzero of every task */
+} tasks_plan;
+
+tasks_plan *tasks_build(
+  uint32_t const * const cscRow,     /*!< CSC row indices */
+  uint32_t const * const cscColumn,  /*!< CSC column start indices */
+  uint32_t const         n,          /*!< Number of rows/columns */
+  int const              workers     /*!< Number of workers */
+);
+
+void tasks_free(tasks_plan *plan);
+
+void tasks_dot(
+  tasks_plan     const * const plan,
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         first,      /*!< First task */
+  uint32_t const         last,       /*!< One past the last task */
+  uint32_t       * const c_values    /*!< C value of every nonzero */
+);
+
+#endif
@@ -0,0 +1,210 @@
+/**
+ *   \file tiling.c
+ *   \brief Cache-blocked traversal of the nonzeros for the V4 dot product
+ *
+ *   Computing C(i,j) reads the lists of columns i and j. Splitting the
+ *   matrix into tile_size x tile_size blocks bounds the lists one tile can
+ *   touch to 2 * tile_size columns, and visiting the tiles along a
+ *   Hilbert (or Z-order) curve makes consecutive tiles share one of the
+ *   two column blocks, so most lists are still in the last-level cache.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "spgemm.h"
+#include "tiling.h"
+
+/* Used when the last-level cache size cannot be queried */
+#define TILING_FALLBACK_LLC (8u << 20)
+
+int tiling_parse_curve(const char *name) {
+  if (name == NULL || strcmp(name, "hilbert") == 0) return TILING_HILBERT;
+  if (strcmp(name, "zorder") == 0) return TILING_ZORDER;
+  return -1;
+}
+
+const char *tiling_curve_name(int curve) {
+  return curve == TILING_ZORDER ? "zorder" : "hilbert";
+}
+
+/**
+ *  \brief Tile side so that the lists of two column blocks fill the LLC
+ */
+uint32_t tiling_default_size(
+  uint32_t const         n,
+  uint32_t const         nnz
+) {
+  long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+  if (llc <= 0) llc = TILING_FALLBACK_LLC;
+
+  /* A column costs its row list plus its cscColumn entry */
+  uint64_t column_bytes = sizeof(uint32_t) * ((n ? nnz / n : 0) + 1);
+  uint64_t size = (uint64_t)llc / (2 * column_bytes);
+
+  if (size < 64) size = 64;
+  if (size > n)  size = n ? n : 1;
+  return (uint32_t)size;
+}
+
+/* Distance of block (x, y) along the Hilbert curve of a side x side grid */
+static uint32_t hilbert_index(uint32_t side, uint32_t x, uint32_t y) {
+  uint32_t d = 0;
+  for (uint32_t s = side / 2; s > 0; s /= 2) {
+    uint32_t rx = (x & s) > 0;
+    uint32_t ry = (y & s) > 0;
+    d += s * s * ((3 * rx) ^ ry);
+    if (ry == 0) {
+      if (rx == 1) {
+        x = side - 1 - x;
+        y = side - 1 - y;
+      }
+      uint32_t t = x;
+      x = y;
+      y = t;
+    }
+  }
+  return d;
+}
+
+/* Interleave the bits of x and y */
+static uint32_t zorder_index(uint32_t x, uint32_t y) {
+  uint32_t d = 0;
+  for (uint32_t b = 0; b < 16; b++) {
+    d |= ((x >> b) & 1u) << (2 * b + 1);
+    d |= ((y >> b) & 1u) << (2 * b);
+  }
+  return d;
+}
+
+/**
+ *  \brief Group the nonzeros by tile, tiles in curve order
+ *
+ *  The curve index of every nonzero is sorted with a stable LSD radix
+ *  sort, so inside a tile the nonzeros keep their column-major order.
+ */
+tiling_schedule *tiling_build(
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         n,
+  uint32_t               tile_size,
+  int const              curve
+) {
+  uint32_t nnz = cscColumn[n];
+
+  if (tile_size == 0) tile_size = tiling_default_size(n, nnz);
+  while ((n + tile_size - 1) / tile_size > TILING_MAX_BLOCKS) tile_size *= 2;
+
+  uint32_t blocks = (n + tile_size - 1) / tile_size;
+  uint32_t side = 1;
+  while (side < blocks) side *= 2;
+
+  uint32_t *key  = malloc(nnz * sizeof(uint32_t));
+  uint32_t *pos  = malloc(nnz * sizeof(uint32_t));
+  uint32_t *col  = malloc(nnz * sizeof(uint32_t));
+  uint32_t *key2 = malloc(nnz * sizeof(uint32_t));
+  uint32_t *pos2 = malloc(nnz * sizeof(uint32_t));
+  uint32_t *col2 = malloc(nnz * sizeof(uint32_t));
+
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (uint32_t j = 0; j < n; j++) {
+    for (uint32_t p = cscColumn[j]; p < cscColumn[j+1]; p++) {
+      uint32_t x = cscRow[p] / tile_size, y = j / tile_size;
+      key[p] = curve == TILING_ZORDER ? zorder_index(x, y) : hilbert_index(side, x, y);
+      pos[p] = p;
+      col[p] = j;
+    }
+  }
+
+  // ----- LSD radix sort on the curve index, 8 bits per pass
+  for (uint32_t shift = 0; shift < 32; shift += 8) {
+    uint32_t count[257] = {0};
+    if (((uint64_t)side * side - 1) >> shift == 0) break;
+
+    for (uint32_t l = 0; l < nnz; l++) count[((key[l] >> shift) & 0xff) + 1]++;
+    for (uint32_t b = 0; b < 256; b++) count[b+1] += count[b];
+    for (uint32_t l = 0; l < nnz; l++) {
+      uint32_t dst = count[(key[l] >> shift) & 0xff]++;
+      key2[dst] = key[l];
+      pos2[dst] = pos[l];
+      col2[dst] = col[l];
+    }
+
+    uint32_t *temp;
+    temp = key; key = key2; key2 = temp;
+    temp = pos; pos = pos2; pos2 = temp;
+    temp = col; col = col2; col2 = temp;
+  }
+
+  tiling_schedule *schedule = malloc(sizeof(tiling_schedule));
+  schedule->tile_size = tile_size;
+  schedule->pos = pos;
+  schedule->col = col;
+
+  // ----- tile boundaries are where the curve index changes
+  schedule->tiles = 0;
+  for (uint32_t l = 0; l < nnz; l++)
+    if (l == 0 || key[l] != key[l-1]) schedule->tiles++;
+
+  schedule->tile_start = malloc((schedule->tiles + 1) * sizeof(uint32_t));
+  for (uint32_t l = 0, t = 0; l < nnz; l++)
+    if (l == 0 || key[l] != key[l-1]) schedule->tile_start[t++] = l;
+  schedule->tile_start[schedule->tiles] = nnz;
+
+  free(key);
+  free(key2);
+  free(pos2);
+  free(col2);
+  return schedule;
+}
+
+void tiling_free(tiling_schedule *schedule) {
+  if (schedule == NULL) return;
+  free(schedule->tile_start);
+  free(schedule->pos);
+  free(schedule->col);
+  free(schedule);
+}
+
+/**
+ *  \brief First tile of part `part` when the tiles are cut into `parts`
+ *  contiguous runs with about the same number of nonzeros each
+ *
+ *  Contiguous runs keep every thread on its own stretch of the curve.
+ *  tiling_split(s, parts, parts) is s->tiles.
+ */
+uint32_t tiling_split(
+  tiling_schedule const * const schedule,
+  uint32_t const         part,
+  uint32_t const         parts
+) {
+  uint64_t target = (uint64_t)schedule->tile_start[schedule->tiles] * part / parts;
+  uint32_t lo = 0, hi = schedule->tiles;
+
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (schedule->tile_start[mid] < target) lo = mid + 1;
+    else                                    hi = mid;
+  }
+  return lo;
+}
+
+/**
+ *  \brief Masked dot product for every nonzero of the tiles [first, last)
+ */
+void tiling_dot_tiles(
+  tiling_schedule const * const schedule,
+  uint32_t const * const cscRow,
+  uint32_t const * const cscColumn,
+  uint32_t const         first,
+  uint32_t const         last,
+  uint32_t       * const c_values
+) {
+  for (uint32_t l = schedule->tile_start[first]; l < schedule->tile_start[last]; l++) {
+    uint32_t p = schedule->pos[l];
+    c_values[p] = spgemm_intersect(cscRow, cscColumn, cscRow[p], schedule->col[l]);
+  }
+}
@@ -0,0 +1,57 @@
+#ifndef TILING_H
+#define TILING_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Order in which the 2D tiles are visited */
+#define TILING_HILBERT  0
+#define TILING_ZORDER   1
+
+/* Tiles per side are capped so that curve indices fit in 32 bits */
+#define TILING_MAX_BLOCKS 65536
+
+typedef struct {
+  uint32_t  tile_size;   /*!< Rows/columns per tile side */
+  uint32_t  tiles;       /*!< Number of nonempty tiles */
+  uint32_t *tile_start;  /*!< Start of every tile in pos/col (tiles+1) */
+  uint32_t *pos;         /*!< Position in cscRow of every nonzero, tile by tile */
+  uint32_t *col;         /*!< Column of every nonzero, tile by tile */
+} tiling_schedule;
+
+int tiling_parse_curve(const char *name);
+
+const char *tiling_curve_name(int curve);
+
+uint32_t tiling_default_size(
+  uint32_t const         n,          /*!< Number of rows/columns */
+  uint32_t const         nnz         /*!< Number of nonzero elements */
+);
+
+tiling_schedule *tiling_build(
+  uint32_t const * const cscRow,     /*!< CSC row indices */
+  uint32_t const * const cscColumn,  /*!< CSC column start indices */
+  uint32_t const         n,          /*!< Number of rows/columns */
+  uint32_t               tile_size,  /*!< Tile side, 0 picks tiling_default_size */
+  int const              curve       /*!< TILING_HILBERT or TILING_ZORDER */
+);
+
+void tiling_free(tiling_schedule *schedule);
+
+uint32_t tiling_split(
+  tiling_schedule const * const schedule,
+  uint32_t const         part,       /*!< Index of the part, 0 .. parts */
+  uint32_t const         parts       /*!< Number of parts */
+);
+
+void tiling_dot_tiles(
+  tiling_schedule const * const schedule,
+  uint32_t const * const cscRow,     /*!< CSC row indices, sorted per column */
+  uint32_t const * const cscColumn,  /*!< CSC column start indices */
+  uint32_t const         first,      /*!< First tile to compute */
+  uint32_t const         last,       /*!< One past the last tile */
+  uint32_t       * const c_values    /*!< C values, same pattern as A */
+);
+
+#endif
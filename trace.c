@@ -0,0 +1,83 @@
+/**
+ *   \file trace.c
+ *   \brief Timeline of phases and scheduled chunks as Chrome trace events
+ *
+ *   Every worker appends the chunks it ran to its own ring, the calling
+ *   thread appends the phases to another. The file opens in
+ *   chrome://tracing or Perfetto with one row per worker, so idle gaps
+ *   and stragglers show up next to the phase boundaries.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "trace.h"
+
+static void ring_init(trace_ring *r) {
+  r->event = malloc(TRACE_RING * sizeof(trace_event));
+  r->written = 0;
+}
+
+trace_log *trace_create(double const origin) {
+  trace_log *t = calloc(1, sizeof(trace_log));
+  t->origin = origin;
+  ring_init(&t->main);
+  return t;
+}
+
+/* Rings for the workers of the next kernel, the ones already there keep their events */
+void trace_workers(trace_log *t, int const workers) {
+  if (workers <= t->workers) return;
+  t->ring = realloc(t->ring, workers * sizeof(trace_ring));
+  for (int w = t->workers; w < workers; w++) ring_init(&t->ring[w]);
+  t->workers = workers;
+}
+
+static int write_ring(FILE *f, trace_log const *t, trace_ring const *r, int const tid,
+                      const char *category, int first_event) {
+  uint64_t from = r->written > TRACE_RING ? r->written - TRACE_RING : 0;
+
+  for (uint64_t k = from; k < r->written; k++) {
+    trace_event const *e = &r->event[k % TRACE_RING];
+    fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+            first_event ? "" : ",", e->name, category, tid,
+            (e->start - t->origin) * 1e6, (e->end - e->start) * 1e6);
+    if (e->last > e->first) fprintf(f, ",\"args\":{\"first\":%u,\"last\":%u}", e->first, e->last);
+    fprintf(f, "}");
+    first_event = 0;
+  }
+  return first_event;
+}
+
+/**
+ *  \brief Write the Chrome trace event JSON, returns 0 on success
+ */
+int trace_write(trace_log const *t, const char *filename) {
+  FILE *f = fopen(filename, "w");
+  if (f == NULL) return 1;
+
+  /* The calling thread is tid 0, worker w is tid w+1 */
+  fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  fprintf(f, "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"phases\"}}");
+  for (int w = 0; w < t->workers; w++)
+    fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}", w + 1, w);
+  write_ring(f, t, &t->main, 0, "phase", 0);
+  for (int w = 0; w < t->workers; w++) {
+    write_ring(f, t, &t->ring[w], w + 1, "chunk", 0);
+    if (t->ring[w].written > TRACE_RING)
+      fprintf(stderr, "Trace: worker %d dropped its %llu oldest chunks\n", w,
+              (unsigned long long)(t->ring[w].written - TRACE_RING));
+  }
+  fprintf(f, "\n]}\n");
+  fclose(f);
+  return 0;
+}
+
+void trace_free(trace_log *t) {
+  if (t == NULL) return;
+  for (int w = 0; w < t->workers; w++) free(t->ring[w].event);
+  free(t->ring);
+  free(t->main.event);
+  free(t);
+}
@@ -0,0 +1,50 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Events kept per thread, older ones are overwritten */
+#define TRACE_RING 65536
+
+typedef struct {
+  double       start;        /*!< Seconds on the profile clock */
+  double       end;
+  uint32_t     first;        /*!< Work items of a chunk, 0 for phases */
+  uint32_t     last;
+  const char  *name;         /*!< Static string, phase or engine */
+} trace_event;
+
+/* Written by one thread only, so no locks or atomics */
+typedef struct {
+  trace_event *event;
+  uint64_t     written;      /*!< Events recorded, more than TRACE_RING means some were dropped */
+} trace_ring;
+
+typedef struct {
+  double       origin;       /*!< Time zero of the timeline */
+  int          workers;
+  trace_ring  *ring;         /*!< One per worker */
+  trace_ring   main;         /*!< Phases of the calling thread */
+} trace_log;
+
+trace_log *trace_create(double const origin);
+
+void trace_workers(trace_log *t, int const workers);
+
+static inline void trace_record(trace_ring *r, double const start, double const end,
+                                uint32_t const first, uint32_t const last, const char *name) {
+  trace_event *e = &r->event[r->written++ % TRACE_RING];
+  e->start = start;
+  e->end = end;
+  e->first = first;
+  e->last = last;
+  e->name = name;
+}
+
+int trace_write(trace_log const *t, const char *filename);
+
+void trace_free(trace_log *t);
+
+#endif
@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "reorder.h"
+#include "tiling.h"
+#include "affinity.h"
+#include "libtriangle.h"
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [martix-market-filename, file.csc or rmat:scale=S,edges=E,a=,b=,c=,seed= | er:n=N,p=P,seed= | mycielskian:k=K] [--engine auto|v3|v4|bitmap|hubs|packed|dot|gustavson|hash|lower|tiled|tasks|edges] [--backend seq|openmp|cilk|pthreads|threads=N] [--threads=N] [--reorder none|degree|rcm|gorder] [--tile N, 0 fits the LLC] [--curve hilbert|zorder] [--chunks N per worker] [--prune] [--pinning none|compact|scatter] [--placement touch|interleave] [--profile] [--counters] [--json file] [--trace file]\n", name);
+    exit(1);
+}
+
+/* --name value or --name=value */
+static const char *option(int argc, char *argv[], int *i, const char *name) {
+    size_t len = strlen(name);
+    if (strncmp(argv[*i], name, len) != 0) return NULL;
+    if (argv[*i][len] == '=') return argv[*i] + len + 1;
+    if (argv[*i][len] == '\0' && *i + 1 < argc) return argv[++*i];
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    triangle_options opt;
+    triangle_coo coo;
+    triangle_graph g;
+    triangle_result r;
+    profile prof;
+    const char *value, *json = NULL, *trace = NULL;
+    int profiling = 0;
+
+    triangle_default_options(&opt);
+    memset(&prof, 0, sizeof(profile));
+    if (argc < 2 || argv[1][0] == '-') usage(argv[0]);
+
+    for (int i = 2; i < argc; i++) {
+        if ((value = option(argc, argv, &i, "--engine"))) {
+            if ((opt.engine = triangle_parse_engine(value)) < 0) usage(argv[0]);
+        }
+        else if ((value = option(argc, argv, &i, "--backend"))) {
+            /* threads=N alone means the pthreads backend with N workers */
+            if (strncmp(value, "threads=", 8) == 0) {
+                opt.backend = TRIANGLE_PTHREADS;
+                opt.workers = atoi(value + 8);
+            }
+            else if ((opt.backend = triangle_parse_backend(value)) < 0) usage(argv[0]);
+        }
+        else if ((value = option(argc, argv, &i, "--threads"))) {
+            opt.workers = atoi(value);
+        }
+        else if ((value = option(argc, argv, &i, "--reorder"))) {
+            if ((opt.reorder = reorder_parse(value)) < 0) usage(argv[0]);
+        }
+        else if ((value = option(argc, argv, &i, "--tile"))) {
+            opt.tile_size = atoi(value);
+        }
+        else if ((value = option(argc, argv, &i, "--chunks"))) {
+            opt.chunks = atoi(value);
+        }
+        else if ((value = option(argc, argv, &i, "--curve"))) {
+            if ((opt.curve = tiling_parse_curve(value)) < 0) usage(argv[0]);
+        }
+        else if ((value = option(argc, argv, &i, "--pinning"))) {
+            if ((opt.layout = affinity_parse(value)) < 0) usage(argv[0]);
+        }
+        else if ((value = option(argc, argv, &i, "--placement"))) {
+            if ((opt.placement = affinity_parse_placement(value)) < 0) usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--prune") == 0) {
+            /* Peel to the 2-core first, c3 still covers every vertex */
+            opt.prune = 1;
+        }
+        else if (strcmp(argv[i], "--profile") == 0) {
+            profiling = 1;
+        }
+        else if (strcmp(argv[i], "--counters") == 0) {
+            /* Hardware counters per phase and per worker, on top of the timings */
+            profiling = 1;
+            prof.counters = 1;
+        }
+        else if ((value = option(argc, argv, &i, "--json"))) {
+            json = value;
+        }
+        else if ((value = option(argc, argv, &i, "--trace"))) {
+            /* Chrome trace event timeline of the phases and of every chunk */
+            trace = value;
+        }
+        else usage(argv[0]);
+    }
+
+    /* Every phase is timed when asked for a breakdown */
+    if (profiling || json || trace) opt.profile = &prof;
+    if (trace) prof.trace = trace_create(profile_now());
+
+    if (triangle_load(argv[1], &opt, &coo) != 0) {
+        printf("Could not load %s\n", argv[1]);
+        exit(1);
+    }
+    triangle_build(&coo, &opt, &g);
+    triangle_coo_free(&coo);
+
+    printf("Matrix Loaded, now Searching!\n");
+    if (opt.placement != g.placement) printf("Cannot interleave (needs make NUMA=1 and several nodes), keeping first touch\n");
+    if (!g.canon.was_canonical) canon_print(&g.canon);
+    if (opt.prune) prune_print(&g.prune);
+    if (opt.engine == TRIANGLE_AUTO) {
+        /* Why this engine, --engine and --chunks override the choice */
+        stats_print(&g.stats);
+        for (char *line = g.reason; *line; line = strchr(line, '\n') + 1)
+            printf("Auto %.*s\n", (int)(strchr(line, '\n') - line), line);
+    }
+    if (triangle_count(&g, &opt, &r) != 0) {
+        printf("Backend %s is not available in this build\n", triangle_backend_name(opt.backend));
+        exit(1);
+    }
+
+    printf("\nBackend: %s", triangle_backend_name(opt.backend));
+    printf("\nThreads: %d", r.workers);
+    printf("\nEngine: %s", triangle_engine_name(r.engine));
+    if (g.packed)
+        printf("\nPacked: %.2f MB of rows against %.2f MB unpacked (%.2fx)", g.packed->bytes / 1e6,
+               g.nnz * sizeof(uint32_t) / 1e6, (double)g.nnz * sizeof(uint32_t) / g.packed->bytes);
+    if (r.engine == TRIANGLE_HUBS)
+        printf("\nHubs: %u bitmaps, %.1f%% of the intersections probed", r.hubs, 100 * r.hub_share);
+    printf("\nTriangle Sum: %llu", (unsigned long long)r.triangles);
+    printf("\nPinning: %s", affinity_name(opt.layout));
+    printf("\nPlacement: %s", affinity_placement_name(g.placement));
+    printf("\nPrepare time: %f", r.prepare_time);
+    printf("\nReorder: %s", reorder_name(opt.reorder));
+    printf("\nReorder time: %f\n", g.reorder_time);
+    printf("\nDuration: %f\n", r.duration);
+    if (profiling) profile_print(&prof);
+    if (json) {
+        FILE *f = fopen(json, "w");
+        if (f == NULL) {
+            printf("Could not write %s\n", json);
+            exit(1);
+        }
+        fprintf(f, "{\n\"graph\": \"%s\",\n\"n\": %u,\n\"nnz\": %u,\n", argv[1], g.n, g.nnz);
+        fprintf(f, "\"backend\": \"%s\",\n\"threads\": %d,\n\"engine\": \"%s\",\n",
+                triangle_backend_name(opt.backend), r.workers, triangle_engine_name(r.engine));
+        if (opt.prune)
+            fprintf(f, "\"prune\": {\"vertices\": %u, \"edges\": %u, \"kept_vertices\": %u, \"kept_edges\": %u, \"leaves\": %u, \"seconds\": %.9f},\n",
+                    g.prune.vertices, g.prune.edges, g.prune.kept_vertices, g.prune.kept_edges, g.prune.leaves, g.prune.seconds);
+        if (opt.engine == TRIANGLE_AUTO) {
+            fprintf(f, "\"stats\": ");
+            stats_write_json(&g.stats, f);
+            fprintf(f, ",\n");
+        }
+        fprintf(f, "\"triangles\": %llu,\n\"duration\": %.9f,\n\"profile\": ",
+                (unsigned long long)r.triangles, r.duration);
+        profile_write_json(&prof, f);
+        fprintf(f, "\n}\n");
+        fclose(f);
+    }
+
+    if (trace && trace_write(prof.trace, trace) != 0) {
+        printf("Could not write %s\n", trace);
+        exit(1);
+    }
+
+    triangle_result_free(&r);
+    triangle_graph_free(&g);
+    trace_free(prof.trace);
+    profile_free(&prof);
+
+	return 0;
+}
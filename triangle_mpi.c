@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <mpi.h>
+#include "mmio.h"
+#include "dist.h"
+#include "mpi1d.h"
+#include "mpi2d.h"
+#include <string.h>
+
+int main(int argc, char *argv[])
+{
+    int rank, size, provided;
+
+    /* Only the master thread of every rank talks to MPI */
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (argc < 2)
+	{
+		if (rank == 0) fprintf(stderr, "Usage: mpirun -np K %s [martix-market-filename] [engine: 1d or 2d, 2d needs a square K] [threads per rank]\n", argv[0]);
+		MPI_Finalize();
+		exit(1);
+	}
+
+    int two_d = argc > 2 && strcmp(argv[2], "2d") == 0;
+    int num_of_threads = argc > 3 ? atoi(argv[3]) : 1;
+
+    /* Rank 0 reads the matrix, every rank keeps its own columns of L or its block of A */
+    dist_graph g;
+    mpi2d_grid grid;
+    dist_stats st = {{0}, {0}};
+    int failed = two_d ? mpi2d_load_mtx(argv[1], MPI_COMM_WORLD, &grid, &st)
+                       : dist_load_mtx(argv[1], MPI_COMM_WORLD, &g, &st);
+    if (failed) {
+        MPI_Finalize();
+        exit(1);
+    }
+
+    if (rank == 0) printf("Matrix Distributed, now Searching!\n");
+
+    /* Initialize the own part of c3 with zeros*/
+    int* c3;
+    if (two_d) c3 = calloc(grid.bound[grid.row + 1] - grid.bound[grid.row] + 1, sizeof(int));
+    else       c3 = calloc(g.last - g.first + 1, sizeof(int));
+
+    /* We measure time from this point */
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+
+    uint64_t triangle_sum = two_d ? mpi2d_count(&grid, c3, num_of_threads, &st)
+                                  : mpi1d_count(&g, MPI_COMM_WORLD, c3, num_of_threads, &st);
+
+    /* We stop measuring time at this point */
+    double duration = MPI_Wtime() - start;
+    MPI_Reduce(rank == 0 ? MPI_IN_PLACE : &duration, &duration, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        printf("\nRanks: %d", size);
+        printf("\nEngine: %s", two_d ? "2d" : "1d");
+        printf("\nThreads per rank: %d", num_of_threads);
+        printf("\nTriangle Sum: %llu", (unsigned long long)triangle_sum);
+        printf("\nDuration: %f", duration);
+    }
+    dist_report(&st, MPI_COMM_WORLD);
+    if (rank == 0) printf("\n");
+
+    /* Deallocate the arrays */
+    if (two_d) mpi2d_free(&grid);
+    else       dist_free(&g);
+    free(c3);
+
+    MPI_Finalize();
+	return 0;
+}
@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include "mmio.h"
+#include "ooc.h"
+
+#include <omp.h>
+
+int main(int argc, char *argv[])
+{
+    struct timeval start, end;
+
+    if (argc < 5)
+	{
+		fprintf(stderr, "Usage: %s [martix-market-filename] [0 for binary or 1 for non binary] [num of threads] [memory budget in MB] [shard directory]\n", argv[0]);
+		exit(1);
+	}
+    int num_of_threads = atoi(argv[3]);
+    uint64_t budget = (uint64_t)(atof(argv[4]) * (1 << 20));
+    const char* dir = argc > 5 ? argv[5] : "/tmp";
+
+    /* Write the sorted CSC shards of L, the edges never sit in memory all at once */
+    gettimeofday(&start,NULL);
+    ooc_graph *g = ooc_shard_mtx(argv[1], dir, budget);
+    if (g == NULL) {
+        printf("Could not shard %s\n", argv[1]);
+        exit(1);
+    }
+    gettimeofday(&end,NULL);
+    double sharding = (end.tv_sec+(double)end.tv_usec/1000000) - (start.tv_sec+(double)start.tv_usec/1000000);
+
+    printf("Matrix Sharded, now Searching!\n");
+
+    /* Initialize c3 with zeros*/
+    int* c3;
+    c3 = calloc(g->n, sizeof(int));
+
+    /* We measure time from this point */
+    gettimeofday(&start,NULL);
+
+    uint64_t triangle_sum = ooc_count(g, c3, num_of_threads);
+
+    /* We stop measuring time at this point */
+    gettimeofday(&end,NULL);
+    double duration = (end.tv_sec+(double)end.tv_usec/1000000) - (start.tv_sec+(double)start.tv_usec/1000000);
+
+    printf("\nThreads: %d", num_of_threads);
+    printf("\nShards: %u", g->shards);
+    printf("\nShard bytes read: %llu", (unsigned long long)g->bytes_read);
+    printf("\nSharding time: %f", sharding);
+    printf("\nTriangle Sum: %llu", (unsigned long long)triangle_sum);
+    printf("\nDuration: %f\n", duration);
+
+    /* Deallocate the arrays and the shard files */
+    ooc_remove(g);
+    free(c3);
+
+	return 0;
+}
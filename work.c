@@ -0,0 +1,72 @@
+/**
+ *   \file work.c
+ *   \brief Algorithmic work counters of the kernels, compiled in with make WORK=1
+ *
+ *   Wall time says which engine won on a graph, these say why: how many
+ *   wedges V3 walked against how many intersections V4 ran and how long
+ *   the lists were.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "work.h"
+
+#ifdef TRIANGLE_WORK
+__thread work_counters work_local;
+#endif
+
+int work_enabled(void) {
+#ifdef TRIANGLE_WORK
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/* Add the counters of the calling thread to sum (NULL drops them) and restart them */
+void work_take(work_counters *sum) {
+#ifdef TRIANGLE_WORK
+  if (sum) work_merge(sum, &work_local);
+  memset(&work_local, 0, sizeof(work_counters));
+#else
+  (void)sum;
+#endif
+}
+
+void work_merge(work_counters *sum, work_counters const *part) {
+  sum->wedges        += part->wedges;
+  sum->closure_scans += part->closure_scans;
+  sum->intersections += part->intersections;
+  sum->compared      += part->compared;
+  sum->hits          += part->hits;
+  for (int b = 0; b < WORK_BUCKETS; b++) sum->sizes[b] += part->sizes[b];
+}
+
+void work_print(work_counters const *w) {
+  uint64_t operations = 0;
+  for (int b = 0; b < WORK_BUCKETS; b++) operations += w->sizes[b];
+
+  printf("\nWork: %llu wedges, %llu closure scans, %llu intersections, %llu compared, %llu hits",
+         (unsigned long long)w->wedges, (unsigned long long)w->closure_scans,
+         (unsigned long long)w->intersections, (unsigned long long)w->compared,
+         (unsigned long long)w->hits);
+  if (w->hits > 0) printf("\nCompared per hit: %.2f", (double)w->compared / w->hits);
+  printf("\nList sizes (intersections, closure scans or expanded columns):");
+  for (int b = 0; b < WORK_BUCKETS; b++) {
+    if (w->sizes[b] == 0) continue;
+    if (b == 0) printf("\n  %10s %12llu", "0", (unsigned long long)w->sizes[b]);
+    else printf("\n  %4llu-%-5llu %12llu %5.1f%%", 1ULL << (b - 1), (1ULL << b) - 1,
+                (unsigned long long)w->sizes[b], 100.0 * w->sizes[b] / operations);
+  }
+}
+
+void work_write_json(work_counters const *w, FILE *f) {
+  fprintf(f, "{ \"wedges\": %llu, \"closure_scans\": %llu, \"intersections\": %llu, \"compared\": %llu, \"hits\": %llu, \"sizes\": [",
+          (unsigned long long)w->wedges, (unsigned long long)w->closure_scans,
+          (unsigned long long)w->intersections, (unsigned long long)w->compared,
+          (unsigned long long)w->hits);
+  for (int b = 0; b < WORK_BUCKETS; b++) fprintf(f, "%s%llu", b ? ", " : "", (unsigned long long)w->sizes[b]);
+  fprintf(f, "] }");
+}
@@ -0,0 +1,50 @@
+#ifndef WORK_H
+#define WORK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Power of two buckets of the list size histogram */
+#define WORK_BUCKETS 32
+
+typedef struct {
+  uint64_t  wedges;          /*!< Paths i-k-j enumerated */
+  uint64_t  closure_scans;   /*!< V3: lists scanned to close a wedge */
+  uint64_t  intersections;   /*!< Calls of the sorted list intersection */
+  uint64_t  compared;        /*!< List elements stepped over or probed */
+  uint64_t  hits;            /*!< Closing entries found */
+  uint64_t  sizes[WORK_BUCKETS]; /*!< List operations by size, bucket b holds [2^(b-1), 2^b) */
+} work_counters;
+
+/*
+ *  The kernels count into a thread local block through these macros, the
+ *  caller moves it into a per worker total with work_take. Without
+ *  make WORK=1 the macros are empty and the kernels are unchanged.
+ */
+#ifdef TRIANGLE_WORK
+extern __thread work_counters work_local;
+
+static inline uint32_t work_bucket(uint64_t const size) {
+  uint32_t b = size ? 64 - __builtin_clzll(size) : 0;
+  return b < WORK_BUCKETS ? b : WORK_BUCKETS - 1;
+}
+
+#define WORK_ADD(field, amount) (work_local.field += (amount))
+#define WORK_SIZE(size)         (work_local.sizes[work_bucket(size)]++)
+#else
+#define WORK_ADD(field, amount) ((void)0)
+#define WORK_SIZE(size)         ((void)0)
+#endif
+
+int work_enabled(void);
+
+void work_take(work_counters *sum);
+
+void work_merge(work_counters *sum, work_counters const *part);
+
+void work_print(work_counters const *w);
+
+void work_write_json(work_counters const *w, FILE *f);
+
+#endif